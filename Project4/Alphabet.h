@@ -0,0 +1,119 @@
+#ifndef ALPHABET_INCLUDED
+#define ALPHABET_INCLUDED
+
+#include <array>
+#include <cstddef>
+#include <string>
+
+//an alphabet is a policy class saying which characters are letters. it needs:
+//	SIZE				how many letters there are
+//	LOWERCASE[i]		the lowercase form of letter i
+//	UPPERCASE[i]		the uppercase form of letter i
+//	WORD_PUNCTUATION	a character that can appear inside a word without being a letter (like the
+//						apostrophe in "don't"). it only ever matches itself
+//everything built from an alphabet is a constant, so code using one never calls isalpha/tolower
+
+//the only alphabet the project uses so far
+struct EnglishAlphabet
+{
+	static constexpr int SIZE = 26;
+	static constexpr char LOWERCASE[SIZE + 1] = "abcdefghijklmnopqrstuvwxyz";
+	static constexpr char UPPERCASE[SIZE + 1] = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	static constexpr char WORD_PUNCTUATION = '\'';
+};
+
+//builders for Letters' tables, run by the compiler
+
+//the index of each character's letter (either case), or -1 if it isn't one
+template <class Alphabet>
+constexpr std::array<signed char, 256> makeLetterIndexTable()
+{
+	std::array<signed char, 256> table = {};
+	for (int c = 0; c < 256; c++)
+		table[c] = -1;
+	for (int i = 0; i < Alphabet::SIZE; i++)
+	{
+		table[static_cast<unsigned char>(Alphabet::LOWERCASE[i])] = static_cast<signed char>(i);
+		table[static_cast<unsigned char>(Alphabet::UPPERCASE[i])] = static_cast<signed char>(i);
+	}
+	return table;
+}
+
+template <class Alphabet>
+constexpr std::array<bool, 256> makeIsUpperTable()
+{
+	std::array<bool, 256> table = {};
+	for (int i = 0; i < Alphabet::SIZE; i++)
+		table[static_cast<unsigned char>(Alphabet::UPPERCASE[i])] = true;
+	return table;
+}
+
+//every character maps to itself, except the letters of fromCase which map to toCase
+template <class Alphabet>
+constexpr std::array<char, 256> makeCaseTable(const char* fromCase, const char* toCase)
+{
+	std::array<char, 256> table = {};
+	for (int c = 0; c < 256; c++)
+		table[c] = static_cast<char>(c);
+	for (int i = 0; i < Alphabet::SIZE; i++)
+		table[static_cast<unsigned char>(fromCase[i])] = toCase[i];
+	return table;
+}
+
+//lookup tables built at compile time from an alphabet, indexed by character
+template <class Alphabet>
+class Letters
+{
+public:
+	static constexpr int SIZE = Alphabet::SIZE;
+	//what indexOf returns for anything that isn't a letter (the -1 in makeLetterIndexTable)
+	static constexpr int NOT_A_LETTER = -1;
+	//what a letter with no translation yet translates to
+	static constexpr char UNKNOWN = '?';
+
+	//which letter c is (either case), from 0 to SIZE - 1, or NOT_A_LETTER
+	static constexpr int indexOf(char c) { return INDEX[static_cast<unsigned char>(c)]; }
+	static constexpr bool isLetter(char c) { return indexOf(c) != NOT_A_LETTER; }
+	static constexpr bool isUpper(char c) { return IS_UPPER[static_cast<unsigned char>(c)]; }
+	//letters go to lowercase, everything else stays the same
+	static constexpr char toLower(char c) { return LOWER[static_cast<unsigned char>(c)]; }
+	static constexpr char toUpper(char c) { return UPPER[static_cast<unsigned char>(c)]; }
+	//the lowercase form of letter i
+	static constexpr char letter(int i) { return Alphabet::LOWERCASE[i]; }
+	static constexpr bool isWordPunctuation(char c) { return c == Alphabet::WORD_PUNCTUATION; }
+	//a letter or word punctuation, the only characters dictionary words are made of
+	static constexpr bool isWordCharacter(char c) { return isLetter(c) || isWordPunctuation(c); }
+
+	//O(L), L = length of word. writes the letter pattern of word[0, length) into patternOut[0, length): each
+	//distinct character (ignoring case) becomes the next of 'A', 'B', ... in order of first appearance, so
+	//"Happy" is ABCCD. a cipher word can only stand for dictionary words with the same pattern
+	static void getLetterPattern(const char* word, std::size_t length, char* patternOut)
+	{
+		//the pattern letter of each character seen so far, by its lowercase form ('\0' for not seen yet)
+		char charsSeen[256] = {};
+		char nextCAPLetterToUse = 'A';
+		for (std::size_t i = 0; i < length; i++)
+		{
+			unsigned char c = static_cast<unsigned char>(toLower(word[i]));
+			if (charsSeen[c] == '\0')
+				charsSeen[c] = nextCAPLetterToUse++;
+			patternOut[i] = charsSeen[c];
+		}
+	}
+	static std::string getLetterPattern(const std::string& word)
+	{
+		std::string pattern(word.size(), '\0');
+		getLetterPattern(word.data(), word.size(), &pattern[0]);
+		return pattern;
+	}
+private:
+	static constexpr std::array<signed char, 256> INDEX = makeLetterIndexTable<Alphabet>();
+	static constexpr std::array<bool, 256> IS_UPPER = makeIsUpperTable<Alphabet>();
+	static constexpr std::array<char, 256> LOWER = makeCaseTable<Alphabet>(Alphabet::UPPERCASE, Alphabet::LOWERCASE);
+	static constexpr std::array<char, 256> UPPER = makeCaseTable<Alphabet>(Alphabet::LOWERCASE, Alphabet::UPPERCASE);
+};
+
+//what the rest of the project uses
+typedef Letters<EnglishAlphabet> EnglishLetters;
+
+#endif // ALPHABET_INCLUDED
@@ -0,0 +1,111 @@
+#ifndef BASICTRANSLATOR_INCLUDED
+#define BASICTRANSLATOR_INCLUDED
+
+#include "Alphabet.h"
+#include <string>
+#include <vector>
+
+//Translator for any alphabet (see Alphabet.h). each mapping is a pair of fixed-size letter arrays,
+//so pushing, popping and checking consistency never touch a hash table or the heap (other than the
+//stack of saved mappings growing)
+template <class Alphabet>
+class BasicTranslator
+{
+public:
+	BasicTranslator();
+	bool pushMapping(const std::string& ciphertext, const std::string& plaintext);
+	bool popMapping();
+	std::string getTranslation(const std::string& ciphertext) const;
+private:
+	typedef Letters<Alphabet> L;
+
+	//both directions of one mapping. each entry is a lowercase letter, or L::UNKNOWN if unmapped
+	struct Mapping
+	{
+		char cipherToPlain[L::SIZE];
+		char plainToCipher[L::SIZE];
+	};
+
+	Mapping m_curr;
+	//every mapping pushMapping replaced, most recent at the back
+	std::vector<Mapping> m_savedMappings;
+};
+
+//O(S), S = size of the alphabet
+template <class Alphabet>
+BasicTranslator<Alphabet>::BasicTranslator()
+{
+	//every letter starts out unmapped both ways
+	for (int i = 0; i < L::SIZE; i++)
+	{
+		m_curr.cipherToPlain[i] = L::UNKNOWN;
+		m_curr.plainToCipher[i] = L::UNKNOWN;
+	}
+}
+
+//O(N + S)
+template <class Alphabet>
+bool BasicTranslator<Alphabet>::pushMapping(const std::string& ciphertext, const std::string& plaintext)
+{
+	//check params have the same length, return false if they don't
+	if (ciphertext.size() != plaintext.size())
+		return false;
+
+	//build the new mapping in a copy, so a bad letter halfway through leaves the current one alone.
+	//checking against the copy also catches pairs that disagree with earlier pairs in the same push
+	Mapping next = m_curr;
+	for (unsigned int i = 0; i < plaintext.size(); i++)
+	{
+		int cipherIndex = L::indexOf(ciphertext[i]);
+		int plainIndex = L::indexOf(plaintext[i]);
+		//if either has a non-letter, return false
+		if (cipherIndex == L::NOT_A_LETTER || plainIndex == L::NOT_A_LETTER)
+			return false;
+
+		//if either letter is already mapped to something else, the pairing is inconsistent
+		char plainLetter = L::letter(plainIndex);
+		char cipherLetter = L::letter(cipherIndex);
+		char& mappedPlain = next.cipherToPlain[cipherIndex];
+		char& mappedCipher = next.plainToCipher[plainIndex];
+		if ((mappedPlain != L::UNKNOWN && mappedPlain != plainLetter) || (mappedCipher != L::UNKNOWN && mappedCipher != cipherLetter))
+			return false;
+		mappedPlain = plainLetter;
+		mappedCipher = cipherLetter;
+	}
+
+	//save the current mapping so popMapping can go back to it, then switch to the new one
+	m_savedMappings.push_back(m_curr);
+	m_curr = next;
+	return true;
+}
+
+//O(S)
+template <class Alphabet>
+bool BasicTranslator<Alphabet>::popMapping()
+{
+	//if there's noting to pop return false
+	if (m_savedMappings.empty())
+		return false;
+	m_curr = m_savedMappings.back();
+	m_savedMappings.pop_back();
+	return true;
+}
+
+//O(N), N is length of param
+template <class Alphabet>
+std::string BasicTranslator<Alphabet>::getTranslation(const std::string& ciphertext) const
+{
+	//non-letters stay as they are, and each letter becomes what it maps to, in the same case
+	std::string translation(ciphertext);
+	for (unsigned int i = 0; i < translation.size(); i++)
+	{
+		int cipherIndex = L::indexOf(translation[i]);
+		if (cipherIndex == L::NOT_A_LETTER)
+			continue;
+		char plainLetter = m_curr.cipherToPlain[cipherIndex];
+		translation[i] = L::isUpper(translation[i]) ? L::toUpper(plainLetter) : plainLetter;
+	}
+	return translation;
+}
+
+#endif // BASICTRANSLATOR_INCLUDED
@@ -0,0 +1,251 @@
+#include "BatchRunner.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <vector>
+
+#ifndef _WIN32
+#include <cerrno>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+//******************** process helpers ***************************************
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef _WIN32
+
+//returns true if the directory is there once it returns
+static bool makeDirectory(const std::string& path)
+{
+	return mkdir(path.c_str(), 0777) == 0 || errno == EEXIST;
+}
+
+//returns the new process's id in the parent, 0 in the new process, or -1 if it couldn't be made
+static int startProcess()
+{
+	//anything still buffered would otherwise be written once by each process
+	std::cout.flush();
+	std::cerr.flush();
+	return fork();
+}
+
+//ends a worker without running the parent's cleanup (its destructors and atexit functions)
+static void endProcess(int status)
+{
+	_exit(status);
+}
+
+//waits for any worker to end. sets pid to which, and isClean to whether it exited with status 0.
+//returns false if there are none
+static bool waitForProcess(int& pid, bool& isClean)
+{
+	int status;
+	pid = waitpid(-1, &status, 0);
+	if (pid < 0)
+		return false;
+	isClean = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+	return true;
+}
+
+static int getProcessId()
+{
+	return getpid();
+}
+
+#else
+
+//no fork on windows yet, so a batch never starts
+static bool makeDirectory(const std::string&) { return false; }
+static int startProcess() { return -1; }
+static void endProcess(int) {}
+static bool waitForProcess(int&, bool&) { return false; }
+static int getProcessId() { return 0; }
+
+#endif
+
+static bool doesFileExist(const std::string& path)
+{
+	return static_cast<bool>(std::ifstream(path));
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//******************** BatchRunner functions *********************************
+//////////////////////////////////////////////////////////////////////////////
+
+BatchRunner::BatchRunner(Decrypter& decrypter, const BatchOptions& options)
+	: m_decrypter(decrypter), m_options(options), m_numShards(0), m_messagesPerShard(1)
+{
+	m_options.numWorkers = std::max(1, m_options.numWorkers);
+	m_options.maxAttempts = std::max(1, m_options.maxAttempts);
+}
+
+//O(M * crack / P), M = number of messages, P = number of workers
+bool BatchRunner::run(const std::string& inputFile, const std::string& outputFile, BatchReport& report)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	report.numMessages = 0;
+	report.numShards = 0;
+	report.numWorkersStarted = 0;
+	report.numRetries = 0;
+	report.numFailedShards = 0;
+	report.seconds = 0;
+
+	std::ifstream input(inputFile);
+	if (!input || !makeDirectory(m_options.spoolDirectory))
+		return false;
+	std::vector<std::string> messages;
+	for (std::string line; std::getline(input, line); )
+	{
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		if (!line.empty())
+			messages.push_back(line);
+	}
+	int numMessages = static_cast<int>(messages.size());
+	m_messagesPerShard = m_options.messagesPerShard > 0 ? m_options.messagesPerShard
+		: std::max(1, (numMessages + m_options.numWorkers * SHARDS_PER_WORKER - 1) / (m_options.numWorkers * SHARDS_PER_WORKER));
+	m_numShards = (numMessages + m_messagesPerShard - 1) / m_messagesPerShard;
+	report.numMessages = numMessages;
+	report.numShards = m_numShards;
+
+	//every shard is waiting before the first worker starts. results left from an earlier batch go first
+	for (int s = 0; s < m_numShards; s++)
+	{
+		std::remove(getShardPath(s, ".done").c_str());
+		std::remove(getShardPath(s, ".failed").c_str());
+		std::ofstream shardFile(getShardPath(s, ".todo"));
+		for (int m = s * m_messagesPerShard; m < std::min(numMessages, (s + 1) * m_messagesPerShard); m++)
+			shardFile << messages[m] << '\n';
+		if (!shardFile)
+			return false;
+	}
+
+	//keep numWorkers workers going for as long as shards are waiting. a worker only stops once it finds
+	//none, so more are only needed when one dies and its shard goes back
+	std::vector<int> numFailures(m_numShards, 0);
+	int numRunning = 0;
+	for (;;)
+	{
+		while (numRunning < m_options.numWorkers && isAnyShardWaiting())
+		{
+			int pid = startProcess();
+			if (pid == 0)
+				endProcess(work());
+			if (pid < 0)
+				break;
+			numRunning++;
+			report.numWorkersStarted++;
+		}
+		int pid;
+		bool isClean;
+		if (numRunning == 0 || !waitForProcess(pid, isClean))
+			break;
+		numRunning--;
+		if (isClean)
+			continue;
+
+		//a worker that died can only have had one shard claimed. if its results made it, only the claim is left
+		std::string processId = std::to_string(pid);
+		for (int s = 0; s < m_numShards; s++)
+		{
+			std::string workPath = getShardPath(s, "." + processId + ".work");
+			if (!doesFileExist(workPath))
+				continue;
+			std::remove(getShardPath(s, "." + processId + ".tmp").c_str());
+			if (doesFileExist(getShardPath(s, ".done")))
+				std::remove(workPath.c_str());
+			else if (++numFailures[s] < m_options.maxAttempts)
+			{
+				std::rename(workPath.c_str(), getShardPath(s, ".todo").c_str());
+				report.numRetries++;
+			}
+			else
+				std::rename(workPath.c_str(), getShardPath(s, ".failed").c_str());
+		}
+	}
+
+	//merge the results in input order. a shard that never got done (given up on, or no worker could be
+	//started) is an error for each of its messages
+	std::ofstream output(outputFile);
+	for (int s = 0; s < m_numShards; s++)
+	{
+		std::ifstream results(getShardPath(s, ".done"), std::ios::binary);
+		if (results)
+			output << results.rdbuf();
+		else
+		{
+			report.numFailedShards++;
+			for (int m = s * m_messagesPerShard; m < std::min(numMessages, (s + 1) * m_messagesPerShard); m++)
+				output << m << " error 0\n";
+		}
+		results.close();
+		std::remove(getShardPath(s, ".done").c_str());
+		std::remove(getShardPath(s, ".failed").c_str());
+		std::remove(getShardPath(s, ".todo").c_str());
+	}
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	return static_cast<bool>(output);
+}
+
+std::string BatchRunner::getShardPath(int shard, const std::string& ending) const
+{
+	return m_options.spoolDirectory + "/" + std::to_string(shard) + ending;
+}
+
+//O(S), S = number of shards
+bool BatchRunner::isAnyShardWaiting() const
+{
+	for (int s = 0; s < m_numShards; s++)
+		if (doesFileExist(getShardPath(s, ".todo")))
+			return true;
+	return false;
+}
+
+int BatchRunner::work()
+{
+	std::string processId = std::to_string(getProcessId());
+	for (;;)
+	{
+		//claim the first shard still waiting. every worker may try the same one, but only one rename wins
+		int shard = -1;
+		for (int s = 0; s < m_numShards && shard < 0; s++)
+			if (std::rename(getShardPath(s, ".todo").c_str(), getShardPath(s, "." + processId + ".work").c_str()) == 0)
+				shard = s;
+		if (shard < 0)
+			return 0;
+		if (!crackShard(shard, processId))
+			return 1;
+	}
+}
+
+//O(S * crack), S = messages in the shard
+bool BatchRunner::crackShard(int shard, const std::string& processId)
+{
+	std::string workPath = getShardPath(shard, "." + processId + ".work");
+	std::string tempPath = getShardPath(shard, "." + processId + ".tmp");
+	std::ifstream shardFile(workPath);
+	std::ofstream results(tempPath, std::ios::binary);
+	int index = shard * m_messagesPerShard;
+	for (std::string message; std::getline(shardFile, message); index++)
+	{
+		CrackResult result = m_decrypter.crack(message, m_options.crackOptions);
+		results << index << (result.timedOut ? " timeout " : result.hitSolutionLimit ? " limit " : " ok ") << result.solutions.size() << '\n';
+		for (unsigned int i = 0; i < result.solutions.size(); i++)
+			results << result.solutions[i] << '\n';
+	}
+	results.close();
+	if (!shardFile.eof() || !results)
+		return false;
+
+	//the results only count once they're all there, so the rename comes before giving up the claim
+	if (std::rename(tempPath.c_str(), getShardPath(shard, ".done").c_str()) != 0)
+		return false;
+	std::remove(workPath.c_str());
+	return true;
+}
@@ -0,0 +1,85 @@
+#ifndef BATCHRUNNER_INCLUDED
+#define BATCHRUNNER_INCLUDED
+
+#include "provided.h"
+#include <string>
+
+//how BatchRunner splits up and runs a batch
+struct BatchOptions
+{
+	//worker processes running at once
+	int numWorkers = 4;
+	//messages in each shard (0 makes about SHARDS_PER_WORKER shards per worker)
+	int messagesPerShard = 0;
+	//times a shard is handed to a worker before its messages are given up on
+	int maxAttempts = 3;
+	//where the shards wait and the results pile up. it's made if it isn't there, and has to be on a local
+	//disk, since only one worker can claim a shard because renaming a file is atomic there
+	std::string spoolDirectory = "p4spool";
+	CrackOptions crackOptions;
+};
+
+//what BatchRunner::run did
+struct BatchReport
+{
+	int numMessages;
+	int numShards;
+	int numWorkersStarted;
+	//times a shard was put back after its worker died, and shards given up on after maxAttempts
+	int numRetries;
+	int numFailedShards;
+	double seconds;
+};
+
+//cracks a file of messages (one per line) with several worker processes, for offline jobs too big
+//for one process.
+//
+//every worker is a fork of this process made after the decrypter is loaded, so they all share its
+//pages: a compiled word list (see WordList::saveCompiledWordList) is mapped once for all of them, and
+//a worker only has its own copy of what it writes to (its cache and its searches). a lazily loaded
+//list would index each word length again in every worker, so turn lazy loading off.
+//
+//the messages are split into shards of consecutive messages, and each shard is a file in the spool
+//directory, named for what's happening to it:
+//	<n>.todo		waiting for a worker
+//	<n>.<pid>.work	claimed by worker pid, which renamed the .todo file (only one rename can succeed)
+//	<n>.done		results, written to <n>.<pid>.tmp and renamed once they're all there
+//a worker that dies leaves its shard claimed. the shard goes back to waiting and another worker is
+//started, up to maxAttempts times. once every shard is done (or given up on) the results go to the
+//output file in input order, each as
+//	"<index> <status> <numSolutions>\n" then each solution followed by '\n'
+//index counts the input's nonempty lines from 0, and status is ok, timeout, limit (as DecryptServer
+//answers) or error, for the messages of a shard that was given up on.
+//one batch at a time can use a spool directory.
+//batches only run on POSIX systems for now; on windows run() always fails
+class BatchRunner
+{
+public:
+	//decrypter has to be loaded already, and has to outlive the runner
+	BatchRunner(Decrypter& decrypter, const BatchOptions& options);
+	//returns false if the input can't be read, or the spool directory or output can't be written
+	bool run(const std::string& inputFile, const std::string& outputFile, BatchReport& report);
+	// We prevent a BatchRunner object from being copied or assigned.
+	BatchRunner(const BatchRunner&) = delete;
+	BatchRunner& operator=(const BatchRunner&) = delete;
+private:
+	//a few shards per worker, so a slow shard doesn't leave the others idle at the end for long
+	static const int SHARDS_PER_WORKER = 4;
+
+	Decrypter& m_decrypter;
+	BatchOptions m_options;
+	//for the batch being run
+	int m_numShards;
+	int m_messagesPerShard;
+
+	//shard's file in the spool directory, with the given ending
+	std::string getShardPath(int shard, const std::string& ending) const;
+	//true if a shard is still waiting for a worker
+	bool isAnyShardWaiting() const;
+	//claims waiting shards and cracks them until there are none. runs in a worker, and returns its exit status
+	int work();
+	//cracks a shard the worker claimed, and marks it done. returns false if the results can't be written
+	bool crackShard(int shard, const std::string& processId);
+};
+
+#endif // BATCHRUNNER_INCLUDED
@@ -0,0 +1,74 @@
+#include "BulkTranslator.h"
+#include "Alphabet.h"
+#include "MappedFile.h"
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+BulkTranslator::BulkTranslator()
+{
+	setKey(std::string(EnglishLetters::SIZE, EnglishLetters::UNKNOWN));
+}
+
+//O(SIZE)
+bool BulkTranslator::setKey(const std::string& key)
+{
+	if (key.size() != static_cast<std::size_t>(EnglishLetters::SIZE))
+		return false;
+	//check the whole key before changing anything
+	unsigned int usedPlain = 0;
+	for (int i = 0; i < EnglishLetters::SIZE; i++)
+	{
+		if (key[i] == EnglishLetters::UNKNOWN)
+			continue;
+		int plainIndex = EnglishLetters::indexOf(key[i]);
+		if (plainIndex == EnglishLetters::NOT_A_LETTER || (usedPlain & (1u << plainIndex)))
+			return false;
+		usedPlain |= 1u << plainIndex;
+	}
+
+	//every byte stands for itself, except the letters
+	for (int c = 0; c < 256; c++)
+		m_table[c] = static_cast<char>(c);
+	for (int i = 0; i < EnglishLetters::SIZE; i++)
+	{
+		char plainLetter = EnglishLetters::toLower(key[i]);
+		m_table[static_cast<unsigned char>(EnglishLetters::letter(i))] = plainLetter;
+		m_table[static_cast<unsigned char>(EnglishLetters::toUpper(EnglishLetters::letter(i)))] = EnglishLetters::toUpper(plainLetter);
+	}
+	return true;
+}
+
+//O(N)
+void BulkTranslator::translate(const char* in, std::size_t size, char* out) const
+{
+	for (std::size_t i = 0; i < size; i++)
+		out[i] = m_table[static_cast<unsigned char>(in[i])];
+}
+
+//O(N), N = size of the file
+bool BulkTranslator::translateFile(const std::string& inFilename, const std::string& outFilename) const
+{
+	//opening the output would cut the input short while it's still mapped, so a file can't be its own output.
+	//an output that doesn't exist yet can't be the input, which equivalent reports as an error
+	std::error_code error;
+	if (std::filesystem::equivalent(inFilename, outFilename, error))
+		return false;
+	MappedFile in;
+	if (!in.open(inFilename))
+		return false;
+	std::ofstream out(outFilename, std::ios::binary);
+	if (!out)
+		return false;
+
+	//translate the mapping a chunk at a time into one reused buffer, writing each chunk as it's done
+	std::vector<char> chunk(CHUNK_SIZE);
+	for (std::size_t offset = 0; offset < in.size(); offset += CHUNK_SIZE)
+	{
+		std::size_t size = (in.size() - offset < CHUNK_SIZE) ? in.size() - offset : CHUNK_SIZE;
+		translate(in.data() + offset, size, chunk.data());
+		if (!out.write(chunk.data(), size))
+			return false;
+	}
+	return static_cast<bool>(out.flush());
+}
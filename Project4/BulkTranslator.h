@@ -0,0 +1,31 @@
+#ifndef BULKTRANSLATOR_INCLUDED
+#define BULKTRANSLATOR_INCLUDED
+
+#include <cstddef>
+#include <string>
+
+//applies a solved key (see Decrypter::crackKeys) to text of any size. a file is mapped rather than read,
+//and written out a chunk at a time, so neither side ever sits in memory as one string
+class BulkTranslator
+{
+public:
+	//starts with no letters known, so every letter translates to '?'
+	BulkTranslator();
+	//key[i] is the plain letter for cipher letter 'a' + i, or '?' if it isn't known. returns false
+	//(keeping the old key) if key isn't one letter or '?' per cipher letter, or uses a plain letter twice
+	bool setKey(const std::string& key);
+	//O(N). out gets size bytes, each letter translated keeping its case and everything else copied.
+	//in and out may be the same buffer
+	void translate(const char* in, std::size_t size, char* out) const;
+	//returns false if the input can't be mapped or the output can't be written. unlike translate, this can't work
+	//in place: it returns false without touching either file if both names are the same file
+	bool translateFile(const std::string& inFilename, const std::string& outFilename) const;
+private:
+	//how much gets translated before each write
+	static const std::size_t CHUNK_SIZE = 1024 * 1024;
+
+	//the translation of every byte value
+	char m_table[256];
+};
+
+#endif // BULKTRANSLATOR_INCLUDED
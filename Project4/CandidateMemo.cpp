@@ -0,0 +1,107 @@
+#include "CandidateMemo.h"
+
+//O(C), C = number of candidates of every word
+CandidateMemo::CandidateMemo(const PreparedProblem& problem, std::size_t maxStoredIndexes)
+	: m_problem(problem), m_maxStoredIndexes(maxStoredIndexes), m_numStoredIndexes(0), m_numLookups(0), m_numHits(0)
+{
+	m_allCandidates.resize(problem.getNumWords());
+	for (int w = 0; w < problem.getNumWords(); w++)
+		for (unsigned int i = 0; i < problem.getWord(w).candidates.size(); i++)
+			m_allCandidates[w].push_back(i);
+}
+
+//O(1) if the list is stored, otherwise O(K * C), K = known letters of the word, C = size of the closest stored ancestor
+CandidateSpan CandidateMemo::getCandidates(int w, const LetterKey& key, std::vector<int>& scratch)
+{
+	m_numLookups++;
+	unsigned int known = m_problem.getWord(w).cipherMask & key.getMappedCipher();
+	const std::vector<int>* list = nullptr;
+	if (known == 0)
+		list = &m_allCandidates[w];
+	else
+		list = m_lists.find(getSignature(w, known, key));
+	if (list != nullptr)
+	{
+		m_numHits++;
+		CandidateSpan span = { list->data(), static_cast<int>(list->size()) };
+		return span;
+	}
+
+	//find the closest ancestor that is stored, dropping known letters from the front of the alphabet.
+	//nothing known is always there, so this ends
+	unsigned int ancestorKnown = known;
+	const std::vector<int>* ancestor = nullptr;
+	while (ancestor == nullptr)
+	{
+		ancestorKnown &= ancestorKnown - 1;
+		ancestor = (ancestorKnown == 0) ? &m_allCandidates[w] : m_lists.find(getSignature(w, ancestorKnown, key));
+	}
+
+	//then put the dropped letters back one at a time (the last one dropped first), storing each list on the way
+	unsigned int missing = known & ~ancestorKnown;
+	while (missing != 0 && m_numStoredIndexes < m_maxStoredIndexes)
+	{
+		unsigned int highest = missing;
+		while (highest & (highest - 1))
+			highest &= highest - 1;
+		std::vector<int> child;
+		filter(w, *ancestor, highest, key, child);
+		ancestorKnown |= highest;
+		missing &= ~highest;
+		m_numStoredIndexes += child.size();
+		ancestor = m_lists.emplace(getSignature(w, ancestorKnown, key), std::move(child));
+	}
+
+	//if the memo filled up on the way, filter the rest in one go into the caller's scratch
+	if (missing != 0)
+	{
+		scratch.clear();
+		filter(w, *ancestor, missing, key, scratch);
+		ancestor = &scratch;
+	}
+	CandidateSpan span = { ancestor->data(), static_cast<int>(ancestor->size()) };
+	return span;
+}
+
+//O(P), P = distinct letters in the word
+std::string CandidateMemo::getSignature(int w, unsigned int known, const LetterKey& key) const
+{
+	//four bytes of word index, then one byte per distinct letter: 0 if unknown, else 1 + its plain letter
+	const PreparedProblem::Word& word = m_problem.getWord(w);
+	std::string signature(4 + word.letters.size(), '\0');
+	for (int b = 0; b < 4; b++)
+		signature[b] = static_cast<char>((static_cast<unsigned int>(w) >> (8 * b)) & 0xFF);
+	for (unsigned int i = 0; i < word.letters.size(); i++)
+		if (known & (1u << word.letters[i]))
+			signature[4 + i] = static_cast<char>(1 + key.getPlain(word.letters[i]));
+	return signature;
+}
+
+//O(C * K), C = size of parent, K = letters to check
+void CandidateMemo::filter(int w, const std::vector<int>& parent, unsigned int letters, const LetterKey& key, std::vector<int>& out) const
+{
+	//the slot of each letter to check in the candidates' pairs, and the plain letter it has to have
+	const PreparedProblem::Word& word = m_problem.getWord(w);
+	int slots[EnglishLetters::SIZE];
+	unsigned char plains[EnglishLetters::SIZE];
+	int numChecks = 0;
+	for (unsigned int i = 0; i < word.letters.size(); i++)
+	{
+		if (letters & (1u << word.letters[i]))
+		{
+			slots[numChecks] = i;
+			plains[numChecks] = static_cast<unsigned char>(key.getPlain(word.letters[i]));
+			numChecks++;
+		}
+	}
+
+	for (unsigned int p = 0; p < parent.size(); p++)
+	{
+		const PreparedProblem::LetterPair* pairs = &word.pairs[word.candidates[parent[p]].firstPair];
+		bool agrees = true;
+		for (int c = 0; c < numChecks && agrees; c++)
+			agrees = pairs[slots[c]].plain == plains[c];
+		if (agrees)
+			out.push_back(parent[p]);
+	}
+}
@@ -0,0 +1,57 @@
+#ifndef CANDIDATEMEMO_INCLUDED
+#define CANDIDATEMEMO_INCLUDED
+
+#include "PreparedProblem.h"
+#include "MyHash.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//some of a word's candidates, as indexes into PreparedProblem::Word::candidates. the memory belongs to
+//whoever handed it out, and never changes
+struct CandidateSpan
+{
+	const int* indexes;
+	int size;
+};
+
+//remembers, for one crack(), which of a word's candidates agree with what the key already says about
+//that word's letters. a list is keyed by the word plus the plain letter of each of its letters the key
+//knows, so every branch of the search that knows the same things about a word shares one list.
+//a list that isn't there yet is filtered from its parent (the same constraint, minus the known letter
+//that comes first in the alphabet), never from the word's whole pattern bucket
+class CandidateMemo
+{
+public:
+	//once maxStoredIndexes indexes are stored in all, new lists are built in the caller's scratch instead
+	CandidateMemo(const PreparedProblem& problem, std::size_t maxStoredIndexes = DEFAULT_MAX_STORED_INDEXES);
+	//returns the candidates of word w that map each letter of w the key knows to the same plain letter.
+	//the key's other letters aren't looked at, so a candidate can still clash with them.
+	//the span may point into scratch, so scratch has to be left alone while the span is used
+	CandidateSpan getCandidates(int w, const LetterKey& key, std::vector<int>& scratch);
+	long long getNumLookups() const { return m_numLookups; }
+	long long getNumHits() const { return m_numHits; }
+	int getNumLists() const { return m_lists.getNumItems(); }
+	// We prevent a CandidateMemo object from being copied or assigned.
+	CandidateMemo(const CandidateMemo&) = delete;
+	CandidateMemo& operator=(const CandidateMemo&) = delete;
+private:
+	//4M indexes is 16 MB
+	static const std::size_t DEFAULT_MAX_STORED_INDEXES = 4 * 1024 * 1024;
+
+	const PreparedProblem& m_problem;
+	//for each word, the indexes of all its candidates (the list for knowing none of its letters)
+	std::vector<std::vector<int>> m_allCandidates;
+	MyHash<std::string, std::vector<int>> m_lists;
+	std::size_t m_maxStoredIndexes;
+	std::size_t m_numStoredIndexes;
+	long long m_numLookups;
+	long long m_numHits;
+
+	//the key of word w's list for knowing the letters in known (as the key maps them)
+	std::string getSignature(int w, unsigned int known, const LetterKey& key) const;
+	//adds to out the indexes in parent whose candidates agree with the key on every letter in letters
+	void filter(int w, const std::vector<int>& parent, unsigned int letters, const LetterKey& key, std::vector<int>& out) const;
+};
+
+#endif // CANDIDATEMEMO_INCLUDED
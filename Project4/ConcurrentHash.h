@@ -0,0 +1,163 @@
+#ifndef CONCURRENTHASH_G
+#define CONCURRENTHASH_G
+
+#include "MyHash.h"
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+
+//a MyHash that many threads can use at once. the table is split into NUM_STRIPES smaller MyHashes
+//(stripes), each behind its own reader/writer lock, and a key always lives in the same stripe.
+//lookups only take their stripe's lock shared, so readers never block each other, and writers only
+//block the one stripe they touch. each stripe grows on its own, so a resize only holds up the
+//keys in that stripe, never the whole table.
+//
+//values are copied out instead of returned by pointer, since another thread could change or
+//erase them as soon as the lock is let go
+template <class KeyType, class ValueType, class Hasher = MyHashHasher<KeyType>>
+class ConcurrentHash
+{
+public:
+	ConcurrentHash(double maxLoadFactor = 0.5);
+	~ConcurrentHash();
+	void reset();
+	void associate(const KeyType& key, const ValueType& value);
+	//if the key is in the table, sets value to its value and returns true
+	bool find(const KeyType& key, ValueType& value) const;
+	//returns the key's value, first inserting value for it if the key isn't in the table yet.
+	//if wasInserted isn't nullptr, it's set to whether this call did the insert
+	ValueType findOrInsert(const KeyType& key, const ValueType& value, bool* wasInserted = nullptr);
+	bool erase(const KeyType& key);
+	int getNumItems() const { return m_numItems; }
+	double getLoadFactor() const;
+	// We prevent a ConcurrentHash object from being copied or assigned.
+	ConcurrentHash(const ConcurrentHash&) = delete;
+	ConcurrentHash& operator=(const ConcurrentHash&) = delete;
+private:
+	//must be a power of two. 64 stripes keeps 32 threads mostly out of each other's way
+	static const int NUM_STRIPES = 64;
+
+	//each stripe sits on its own cache line, so locking one doesn't slow down threads using its neighbors
+	struct alignas(64) Stripe
+	{
+		Stripe(double maxLoadFactor) : table(maxLoadFactor) {}
+		mutable std::shared_mutex mutex;
+		MyHash<KeyType, ValueType, Hasher> table;
+	};
+
+	Stripe* m_stripes[NUM_STRIPES];
+	std::atomic<int> m_numItems;
+
+	//the stripe comes from the high bits of the hash, since MyHash picks buckets with the low bits.
+	//multiplying first spreads hashers that don't mix (like char's) across the stripes too
+	Stripe& getStripe(const KeyType& key) const { return *m_stripes[(Hasher()(key) * 0x9E3779B9u) >> 26]; }
+};
+
+//O(S), S = number of stripes
+template <class KeyType, class ValueType, class Hasher>
+ConcurrentHash<KeyType, ValueType, Hasher>::ConcurrentHash(double maxLoadFactor)
+	: m_numItems(0)
+{
+	static_assert(NUM_STRIPES == (1 << (32 - 26)), "the shift in getStripe has to match NUM_STRIPES");
+	for (int i = 0; i < NUM_STRIPES; i++)
+		m_stripes[i] = new Stripe(maxLoadFactor);
+}
+
+//O(B)
+template <class KeyType, class ValueType, class Hasher>
+ConcurrentHash<KeyType, ValueType, Hasher>::~ConcurrentHash()
+{
+	for (int i = 0; i < NUM_STRIPES; i++)
+		delete m_stripes[i];
+}
+
+//O(B). locks one stripe at a time, so other threads can keep inserting into stripes already cleared
+template <class KeyType, class ValueType, class Hasher>
+void ConcurrentHash<KeyType, ValueType, Hasher>::reset()
+{
+	for (int i = 0; i < NUM_STRIPES; i++)
+	{
+		std::unique_lock<std::shared_mutex> lock(m_stripes[i]->mutex);
+		m_numItems -= m_stripes[i]->table.getNumItems();
+		m_stripes[i]->table.reset();
+	}
+}
+
+//O(1)/O(X)/O(B / S) if the stripe has to grow
+template <class KeyType, class ValueType, class Hasher>
+void ConcurrentHash<KeyType, ValueType, Hasher>::associate(const KeyType& key, const ValueType& value)
+{
+	Stripe& stripe = getStripe(key);
+	std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+	int before = stripe.table.getNumItems();
+	stripe.table.associate(key, value);
+	m_numItems += stripe.table.getNumItems() - before;
+}
+
+//O(1)/O(X)
+template <class KeyType, class ValueType, class Hasher>
+bool ConcurrentHash<KeyType, ValueType, Hasher>::find(const KeyType& key, ValueType& value) const
+{
+	Stripe& stripe = getStripe(key);
+	std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+	const ValueType* found = stripe.table.find(key);
+	if (found == nullptr)
+		return false;
+	value = *found;
+	return true;
+}
+
+//O(1)/O(X)/O(B / S) if the stripe has to grow
+template <class KeyType, class ValueType, class Hasher>
+ValueType ConcurrentHash<KeyType, ValueType, Hasher>::findOrInsert(const KeyType& key, const ValueType& value, bool* wasInserted)
+{
+	Stripe& stripe = getStripe(key);
+	//most calls find the key, so look with the shared lock first
+	{
+		std::shared_lock<std::shared_mutex> lock(stripe.mutex);
+		const ValueType* found = stripe.table.find(key);
+		if (found != nullptr)
+		{
+			if (wasInserted != nullptr)
+				*wasInserted = false;
+			return *found;
+		}
+	}
+	//another thread may have inserted it between the two locks, which emplace handles by leaving its value alone
+	std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+	int before = stripe.table.getNumItems();
+	ValueType result = *stripe.table.emplace(key, value);
+	bool inserted = stripe.table.getNumItems() != before;
+	if (inserted)
+		m_numItems++;
+	if (wasInserted != nullptr)
+		*wasInserted = inserted;
+	return result;
+}
+
+//O(1)/O(X)
+template <class KeyType, class ValueType, class Hasher>
+bool ConcurrentHash<KeyType, ValueType, Hasher>::erase(const KeyType& key)
+{
+	Stripe& stripe = getStripe(key);
+	std::unique_lock<std::shared_mutex> lock(stripe.mutex);
+	if (!stripe.table.erase(key))
+		return false;
+	m_numItems--;
+	return true;
+}
+
+//O(S), the average over the stripes (which are about the same size, since keys spread evenly)
+template <class KeyType, class ValueType, class Hasher>
+double ConcurrentHash<KeyType, ValueType, Hasher>::getLoadFactor() const
+{
+	double total = 0;
+	for (int i = 0; i < NUM_STRIPES; i++)
+	{
+		std::shared_lock<std::shared_mutex> lock(m_stripes[i]->mutex);
+		total += m_stripes[i]->table.getLoadFactor();
+	}
+	return total / NUM_STRIPES;
+}
+
+#endif
@@ -0,0 +1,444 @@
+#include "DecryptServer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+#ifndef _WIN32
+#include <arpa/inet.h>
+#include <csignal>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+//******************** socket helpers ****************************************
+//////////////////////////////////////////////////////////////////////////////
+
+#ifndef _WIN32
+
+//returns a socket bound and listening on address (if isServer) or connected to it, or -1
+static int openSocket(const std::string& address, bool isServer)
+{
+	int s;
+	if (address.compare(0, 4, "tcp:") == 0)
+	{
+		sockaddr_in where = {};
+		where.sin_family = AF_INET;
+		where.sin_port = htons(static_cast<unsigned short>(atoi(address.c_str() + 4)));
+		where.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		s = socket(AF_INET, SOCK_STREAM, 0);
+		if (s < 0)
+			return -1;
+		int yes = 1;
+		setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+		if (isServer ? bind(s, reinterpret_cast<sockaddr*>(&where), sizeof(where)) : connect(s, reinterpret_cast<sockaddr*>(&where), sizeof(where)))
+		{
+			::close(s);
+			return -1;
+		}
+	}
+	else
+	{
+		std::string path = address.compare(0, 5, "unix:") == 0 ? address.substr(5) : address;
+		sockaddr_un where = {};
+		where.sun_family = AF_UNIX;
+		if (path.empty() || path.size() >= sizeof(where.sun_path))
+			return -1;
+		path.copy(where.sun_path, path.size());
+		s = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (s < 0)
+			return -1;
+		//a socket file left behind by a server that didn't shut down cleanly would make bind fail
+		if (isServer)
+			unlink(path.c_str());
+		if (isServer ? bind(s, reinterpret_cast<sockaddr*>(&where), sizeof(where)) : connect(s, reinterpret_cast<sockaddr*>(&where), sizeof(where)))
+		{
+			::close(s);
+			return -1;
+		}
+	}
+	if (isServer && ::listen(s, SOMAXCONN) != 0)
+	{
+		::close(s);
+		return -1;
+	}
+	return s;
+}
+
+//waits up to timeoutInMilliseconds for a connection. returns its socket, or -1 if none came
+static int acceptConnection(int listenSocket, int timeoutInMilliseconds)
+{
+	pollfd waitFor = { listenSocket, POLLIN, 0 };
+	if (poll(&waitFor, 1, timeoutInMilliseconds) <= 0)
+		return -1;
+	return accept(listenSocket, nullptr, nullptr);
+}
+
+//makes any read blocked on s return, without freeing s yet
+static void shutdownSocket(int s)
+{
+	shutdown(s, SHUT_RDWR);
+}
+
+static void closeSocket(int s)
+{
+	if (s >= 0)
+		::close(s);
+}
+
+//O(N), N = number of bytes. returns false if the other end closed or something broke first
+static bool readFully(int s, char* buffer, std::size_t numBytes)
+{
+	while (numBytes > 0)
+	{
+		ssize_t numRead = read(s, buffer, numBytes);
+		if (numRead <= 0)
+			return false;
+		buffer += numRead;
+		numBytes -= numRead;
+	}
+	return true;
+}
+
+static bool writeFully(int s, const char* buffer, std::size_t numBytes)
+{
+	while (numBytes > 0)
+	{
+		ssize_t numWritten = write(s, buffer, numBytes);
+		if (numWritten <= 0)
+			return false;
+		buffer += numWritten;
+		numBytes -= numWritten;
+	}
+	return true;
+}
+
+#else
+
+//no sockets on windows yet, so nothing ever opens
+static int openSocket(const std::string&, bool) { return -1; }
+static int acceptConnection(int, int) { return -1; }
+static void shutdownSocket(int) {}
+static void closeSocket(int) {}
+static bool readFully(int, char*, std::size_t) { return false; }
+static bool writeFully(int, const char*, std::size_t) { return false; }
+
+#endif
+
+//O(N), N = length of the frame. a frame longer than maxBytes is taken to be garbage, and nothing past its header is read
+static bool readFrame(int s, std::string& payload, unsigned int maxBytes)
+{
+	unsigned char header[4];
+	if (!readFully(s, reinterpret_cast<char*>(header), 4))
+		return false;
+	unsigned int length = (header[0] << 24) | (header[1] << 16) | (header[2] << 8) | header[3];
+	if (length > maxBytes)
+		return false;
+	payload.resize(length);
+	return length == 0 || readFully(s, &payload[0], length);
+}
+
+//O(N), N = length of the frame
+static bool writeFrame(int s, const std::string& payload)
+{
+	unsigned int length = static_cast<unsigned int>(payload.size());
+	std::string frame(4, '\0');
+	frame[0] = static_cast<char>(length >> 24);
+	frame[1] = static_cast<char>(length >> 16);
+	frame[2] = static_cast<char>(length >> 8);
+	frame[3] = static_cast<char>(length);
+	//one write for header and payload, so two threads' frames can't interleave on the wire
+	frame += payload;
+	return writeFully(s, frame.data(), frame.size());
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//******************** DecryptServer functions *******************************
+//////////////////////////////////////////////////////////////////////////////
+
+struct DecryptServer::Connection
+{
+	Connection(int s) : socket(s), isClosed(false) {}
+	//the last job answered on a connection is what finally closes it
+	~Connection() { closeSocket(socket); }
+	int socket;
+	//held while writing a response, since workers answer in whatever order they finish
+	std::mutex writeMutex;
+	std::atomic<bool> isClosed;
+	std::thread reader;
+};
+
+struct DecryptServer::Job
+{
+	std::shared_ptr<Connection> connection;
+	std::string id;
+	CrackOptions options;
+	std::chrono::steady_clock::time_point deadline;
+	std::string ciphertext;
+};
+
+DecryptServer::DecryptServer(Decrypter& decrypter, int numWorkers)
+	: m_decrypter(decrypter), m_numWorkers(std::max(1, numWorkers)), m_listenSocket(-1),
+	m_isStopping(false), m_numRequestsServed(0)
+{}
+
+DecryptServer::~DecryptServer()
+{
+	closeSocket(m_listenSocket);
+	if (!m_unixPath.empty())
+		std::remove(m_unixPath.c_str());
+}
+
+//O(1)
+bool DecryptServer::listen(const std::string& address)
+{
+	closeSocket(m_listenSocket);
+	m_listenSocket = openSocket(address, true);
+	if (m_listenSocket < 0)
+		return false;
+	//remember the socket file so it can be cleaned up
+	if (address.compare(0, 4, "tcp:") != 0)
+		m_unixPath = address.compare(0, 5, "unix:") == 0 ? address.substr(5) : address;
+	return true;
+}
+
+void DecryptServer::run()
+{
+#ifndef _WIN32
+	//a client hanging up before its answer is written shouldn't kill the server
+	signal(SIGPIPE, SIG_IGN);
+#endif
+	std::vector<std::thread> workers;
+	for (int i = 0; i < m_numWorkers; i++)
+		workers.emplace_back(&DecryptServer::crackRequests, this);
+
+	//poll with a timeout so stop() is noticed even when nobody connects
+	while (!m_isStopping && m_listenSocket >= 0)
+	{
+		int s = acceptConnection(m_listenSocket, 100);
+		forgetClosedConnections();
+		if (s < 0)
+			continue;
+		std::shared_ptr<Connection> connection = std::make_shared<Connection>(s);
+		connection->reader = std::thread(&DecryptServer::readRequests, this, connection);
+		m_connections.push_back(connection);
+	}
+
+	//wake every reader up, and wait for them to finish
+	for (unsigned int i = 0; i < m_connections.size(); i++)
+		shutdownSocket(m_connections[i]->socket);
+	for (unsigned int i = 0; i < m_connections.size(); i++)
+		m_connections[i]->reader.join();
+	m_connections.clear();
+
+	//nobody is left to answer, so drop whatever was still waiting, then let the workers go
+	{
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		for (unsigned int i = 0; i < m_queue.size(); i++)
+			delete m_queue[i];
+		m_queue.clear();
+	}
+	m_queueNotEmpty.notify_all();
+	for (unsigned int i = 0; i < workers.size(); i++)
+		workers[i].join();
+}
+
+//O(1)
+void DecryptServer::stop()
+{
+	m_isStopping = true;
+	m_queueNotEmpty.notify_all();
+}
+
+//O(C), C = number of open connections
+void DecryptServer::forgetClosedConnections()
+{
+	for (unsigned int i = 0; i < m_connections.size(); )
+	{
+		if (m_connections[i]->isClosed)
+		{
+			m_connections[i]->reader.join();
+			m_connections[i] = m_connections.back();
+			m_connections.pop_back();
+		}
+		else
+			i++;
+	}
+}
+
+//runs on each connection's own thread until the other end closes it
+void DecryptServer::readRequests(std::shared_ptr<Connection> connection)
+{
+	std::string payload;
+	while (!m_isStopping && readFrame(connection->socket, payload, MAX_REQUEST_BYTES))
+	{
+		Job* job = new Job;
+		job->connection = connection;
+		std::size_t endOfHeader = payload.find('\n');
+		std::istringstream header(payload.substr(0, endOfHeader));
+		if (endOfHeader == std::string::npos
+			|| !(header >> job->id >> job->options.deadlineInMilliseconds >> job->options.maxSolutions))
+		{
+			//can't be cracked, so answer it right here instead of queueing it
+			std::lock_guard<std::mutex> lock(connection->writeMutex);
+			writeFrame(connection->socket, (job->id.empty() ? "?" : job->id) + " error 0\n");
+			delete job;
+			continue;
+		}
+		//no limit (or one past what a response holds) means the most a response holds
+		if (job->options.maxSolutions <= 0 || job->options.maxSolutions > MAX_SOLUTIONS_PER_RESPONSE)
+			job->options.maxSolutions = MAX_SOLUTIONS_PER_RESPONSE;
+		job->deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(job->options.deadlineInMilliseconds);
+		job->ciphertext = payload.substr(endOfHeader + 1);
+
+		std::lock_guard<std::mutex> lock(m_queueMutex);
+		m_queue.push_back(job);
+		m_queueNotEmpty.notify_one();
+	}
+	connection->isClosed = true;
+}
+
+//runs on each worker thread until the server stops
+void DecryptServer::crackRequests()
+{
+	for (;;)
+	{
+		Job* job;
+		{
+			std::unique_lock<std::mutex> lock(m_queueMutex);
+			m_queueNotEmpty.wait(lock, [this] { return m_isStopping || !m_queue.empty(); });
+			if (m_queue.empty())
+				return;
+			job = m_queue.front();
+			m_queue.pop_front();
+		}
+
+		//whatever time the job spent in the queue comes out of its deadline
+		CrackResult result;
+		bool isOutOfTime = false;
+		if (job->options.deadlineInMilliseconds > 0)
+		{
+			long long remaining = std::chrono::duration_cast<std::chrono::milliseconds>(job->deadline - std::chrono::steady_clock::now()).count();
+			isOutOfTime = remaining <= 0;
+			job->options.deadlineInMilliseconds = static_cast<int>(remaining);
+		}
+		if (isOutOfTime)
+			result.timedOut = true;
+		else
+			result = m_decrypter.crack(job->ciphertext, job->options);
+
+		//the solutions that fit in a response, which otherwise stops early like a crack that hit its limit
+		std::string solutions;
+		std::size_t numSent = 0;
+		for (; numSent < result.solutions.size(); numSent++)
+		{
+			if (solutions.size() + result.solutions[numSent].size() + 1 > MAX_RESPONSE_BYTES - job->id.size() - 32)
+			{
+				result.hitSolutionLimit = true;
+				break;
+			}
+			solutions += result.solutions[numSent] + "\n";
+		}
+		std::string response = job->id + (result.timedOut ? " timeout " : result.hitSolutionLimit ? " limit " : " ok ")
+			+ std::to_string(numSent) + "\n" + solutions;
+		{
+			std::lock_guard<std::mutex> lock(job->connection->writeMutex);
+			writeFrame(job->connection->socket, response);
+		}
+		m_numRequestsServed++;
+		delete job;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//******************** load generator ****************************************
+//////////////////////////////////////////////////////////////////////////////
+
+bool runLoadGenerator(const std::string& address, const std::vector<std::string>& messages, int numRequests,
+	int numConnections, const CrackOptions& options, LoadReport& report)
+{
+	report = LoadReport();
+	if (messages.empty() || numConnections < 1)
+		return false;
+	std::vector<int> sockets;
+	for (int i = 0; i < numConnections; i++)
+	{
+		int s = openSocket(address, false);
+		if (s < 0)
+		{
+			for (unsigned int j = 0; j < sockets.size(); j++)
+				closeSocket(sockets[j]);
+			return false;
+		}
+		sockets.push_back(s);
+	}
+
+	//each connection takes the next request number until they run out
+	std::atomic<int> nextRequest(0);
+	std::mutex reportMutex;
+	std::vector<double> latencies;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	int numSent = 0;
+	std::vector<std::thread> clients;
+	for (int c = 0; c < numConnections; c++)
+	{
+		clients.emplace_back([&, c]
+		{
+			std::string response;
+			for (int r = nextRequest++; r < numRequests; r = nextRequest++)
+			{
+				std::string id = std::to_string(r);
+				std::string request = id + " " + std::to_string(options.deadlineInMilliseconds) + " "
+					+ std::to_string(options.maxSolutions) + "\n" + messages[r % messages.size()];
+				std::chrono::steady_clock::time_point sent = std::chrono::steady_clock::now();
+				bool isAnswered = writeFrame(sockets[c], request) && readFrame(sockets[c], response, DecryptServer::MAX_RESPONSE_BYTES)
+					&& response.compare(0, id.size() + 1, id + " ") == 0;
+				double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sent).count();
+
+				std::lock_guard<std::mutex> lock(reportMutex);
+				numSent++;
+				//whatever is left of a bad answer is still on the socket, so nothing after it would line up
+				if (!isAnswered)
+				{
+					report.numFailed++;
+					report.numConnectionsLost++;
+					closeSocket(sockets[c]);
+					sockets[c] = -1;
+					return;
+				}
+				if (response.compare(id.size() + 1, 5, "error") == 0)
+					report.numFailed++;
+				else
+				{
+					if (response.compare(id.size() + 1, 7, "timeout") == 0)
+						report.numTimedOut++;
+					latencies.push_back(milliseconds);
+				}
+			}
+		});
+	}
+	for (unsigned int i = 0; i < clients.size(); i++)
+		clients[i].join();
+	report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	for (unsigned int i = 0; i < sockets.size(); i++)
+		closeSocket(sockets[i]);
+	//once every connection is lost, the requests nobody sent fail too
+	report.numFailed += std::max(0, numRequests - numSent);
+
+	//nearest-rank percentiles over the requests that got an answer
+	report.numRequests = numRequests;
+	std::sort(latencies.begin(), latencies.end());
+	if (!latencies.empty())
+	{
+		report.p50Milliseconds = latencies[(latencies.size() * 50 + 99) / 100 - 1];
+		report.p99Milliseconds = latencies[(latencies.size() * 99 + 99) / 100 - 1];
+	}
+	if (report.seconds > 0)
+		report.requestsPerSecond = latencies.size() / report.seconds;
+	return true;
+}
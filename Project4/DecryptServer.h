@@ -0,0 +1,96 @@
+#ifndef DECRYPTSERVER_INCLUDED
+#define DECRYPTSERVER_INCLUDED
+
+#include "provided.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+//keeps one loaded Decrypter around and answers crack requests from other processes, so they don't
+//each pay for starting up and loading the dictionary.
+//
+//an address is either a unix domain socket path ("unix:/tmp/p4.sock", or just "/tmp/p4.sock")
+//or a port on the loopback interface ("tcp:7000").
+//
+//every message either way is a frame: a 4 byte big-endian length, then that many bytes.
+//	request:	"<id> <deadlineMs> <maxSolutions>\n<ciphertext>"
+//	response:	"<id> <status> <numSolutions>\n" then each solution followed by '\n'
+//status is ok, timeout, limit (stopped at maxSolutions) or error. the id is whatever the client
+//picked, since requests on one connection can be answered out of order.
+//a response never holds more than MAX_SOLUTIONS_PER_RESPONSE solutions, or more solutions than fit in
+//MAX_RESPONSE_BYTES. a request asking for more (or for no limit, with 0) gets the first ones and limit.
+//a request frame can be at most MAX_REQUEST_BYTES; a longer one closes the connection.
+//
+//each connection has a thread reading its requests, and every request goes on one queue that a fixed
+//pool of workers cracks from. a request's deadline counts from when it was read, so time spent
+//waiting in the queue counts against it.
+//servers only work on POSIX systems for now; on windows listen() always fails
+class DecryptServer
+{
+public:
+	//decrypter has to be loaded already, and has to outlive the server
+	DecryptServer(Decrypter& decrypter, int numWorkers);
+	~DecryptServer();
+	bool listen(const std::string& address);
+	//serves until stop() is called (from another thread)
+	void run();
+	void stop();
+	long long getNumRequestsServed() const { return m_numRequestsServed; }
+	static const int MAX_SOLUTIONS_PER_RESPONSE = 10000;
+	static const unsigned int MAX_REQUEST_BYTES = 1 << 20;
+	static const unsigned int MAX_RESPONSE_BYTES = 16 << 20;
+	// We prevent a DecryptServer object from being copied or assigned.
+	DecryptServer(const DecryptServer&) = delete;
+	DecryptServer& operator=(const DecryptServer&) = delete;
+private:
+	struct Connection;
+	struct Job;
+
+	Decrypter& m_decrypter;
+	int m_numWorkers;
+	int m_listenSocket;
+	std::string m_unixPath;
+	std::atomic<bool> m_isStopping;
+	std::atomic<long long> m_numRequestsServed;
+
+	std::mutex m_queueMutex;
+	std::condition_variable m_queueNotEmpty;
+	std::deque<Job*> m_queue;
+
+	//only touched by run()
+	std::vector<std::shared_ptr<Connection>> m_connections;
+
+	void readRequests(std::shared_ptr<Connection> connection);
+	void crackRequests();
+	//joins the readers of connections the other end has closed
+	void forgetClosedConnections();
+};
+
+//what runLoadGenerator saw
+struct LoadReport
+{
+	int numRequests;
+	//requests that got an error, a bad answer or none at all
+	int numFailed;
+	//connections closed because an answer was bad (or never came), after which nothing more can be read from them
+	int numConnectionsLost;
+	int numTimedOut;
+	double seconds;
+	double p50Milliseconds;
+	double p99Milliseconds;
+	double requestsPerSecond;
+};
+
+//opens numConnections connections to the server at address, and sends numRequests requests over them,
+//taking messages in turn. each connection waits for an answer before sending its next request.
+//the requests a lost connection never got to send go to the others, or fail if none are left.
+//returns false if it couldn't connect
+bool runLoadGenerator(const std::string& address, const std::vector<std::string>& messages, int numRequests,
+	int numConnections, const CrackOptions& options, LoadReport& report);
+
+#endif // DECRYPTSERVER_INCLUDED
@@ -1,182 +1,1354 @@
 #include "provided.h"
+#include "Alphabet.h"
+#include "MyHash.h"
+#include "PreparedProblem.h"
+#include "CandidateMemo.h"
+#include "SearchPlan.h"
 #include <algorithm>	
+#include <atomic>
+#include <chrono>
 #include <list>			
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <thread>
+
+//remembers crack()'s solutions for messages it has seen. the key is the message with its cipher letters
+//relabeled in order of first appearance (like a letter pattern, but over the whole message and keeping
+//case and punctuation), so every message that differs only in which cipher letters were used shares
+//one entry. each solution is stored as the plaintext letter for each relabeled letter, and turned back
+//into plaintext for whichever variant asked
+class ResultCache
+{
+public:
+	ResultCache(std::size_t capacityInBytes);
+	void setCapacity(std::size_t capacityInBytes);
+	//if the message (or a relabeled variant of it) is cached, sets solutions to its plaintexts and returns true.
+	//generation is the word list the caller is cracking with, and only results found with that one are used
+	bool lookup(const std::string& ciphertext, unsigned long long generation, std::vector<std::string>& solutions);
+	void insert(const std::string& ciphertext, unsigned long long generation, const std::vector<std::string>& solutions);
+	//drops everything, and from now on only keeps results found with word list generation
+	void startGeneration(unsigned long long generation);
+	//the same, but only drops the messages with a word (as tokenizer splits it) whose letter pattern is one
+	//of changedPatterns. the rest carry over to the new generation. returns how many were dropped
+	int startGeneration(unsigned long long generation, const MyHash<std::string, bool>& changedPatterns, const Tokenizer& tokenizer);
+	CrackCacheStats getStats() const;
+private:
+	struct Entry
+	{
+		std::string canonical;
+		//keys[s * EnglishLetters::SIZE + i] is the plaintext letter that relabeled letter i stands for in solution s
+		std::string keys;
+		std::size_t bytes;
+	};
+
+	//most recently used entry first. the index's keys are views of the entries' canonical strings
+	std::list<Entry> m_entries;
+	MyHash<std::string_view, std::list<Entry>::iterator> m_index;
+	std::size_t m_capacityInBytes;
+	std::size_t m_bytesUsed;
+	long long m_hits;
+	long long m_misses;
+	long long m_evictions;
+	unsigned long long m_generation;
+	mutable std::mutex m_mutex;
+
+	static std::string canonicalize(const std::string& ciphertext, char cipherToCanonical[EnglishLetters::SIZE]);
+	void evictUntilUnder(std::size_t capacityInBytes);
+};
 
 class DecrypterImpl
 {
 public:
 	DecrypterImpl();
 	bool load(std::string filename);
-	std::vector<std::string> crack(const std::string& ciphertext);
+	bool addWord(const std::string& word);
+	bool removeWord(const std::string& word);
+	int applyDelta(const std::string& filename);
+	void setLazyLoading(bool lazy);
+	std::vector<WordListShardStats> getShardStats() const { return getDictionary()->words.getShardStats(); }
+	void setTableStatsOutput(std::ostream* out);
+	void printTableStats(std::ostream& out) const { getDictionary()->words.printTableStats(out); }
+	void setCacheCapacity(std::size_t bytes) { m_cache.setCapacity(bytes); }
+	CrackCacheStats getCacheStats() const { return m_cache.getStats(); }
+	std::vector<CrackPortfolioStats> getPortfolioStats() const;
+	void setPortfolioLog(std::ostream* out);
+	CrackResult crack(const std::string& ciphertext, const CrackOptions& options);
+	CrackKeysResult crackKeys(const std::string& ciphertext, const CrackOptions& options);
+	JointCrackResult crackJoint(const std::vector<std::string>& ciphertexts, const CrackOptions& options);
+	void explainPlan(const std::string& ciphertext, const CrackOptions& options, std::ostream& out) const;
+	CrackCostEstimate estimateCost(const std::string& ciphertext) const;
 private:
+	//how much memory the result cache starts out allowed to use
+	static const std::size_t DEFAULT_CACHE_CAPACITY = 16 * 1024 * 1024;
+	//a sample that leaves more keys open than this is made bigger instead of checking them all
+	static const int MAX_SAMPLE_KEYS = 1000;
+	//the word orders a portfolio crack races, one thread each
+	static const int NUM_WORD_ORDERS = 3;
+	static const CrackWordOrder WORD_ORDERS[NUM_WORD_ORDERS];
+
+	//one word list, never changed once it's current. load() builds a new one off to the side and swaps it in,
+	//and addWord and the like swap in a changed copy, so cracks never wait for either: each holds on to the
+	//one that was current when it started, which is freed once the last crack using it lets go
+	struct Dictionary
+	{
+		WordList words;
+		//counts loads and changes, so the cache can tell results found with an older word list from current ones
+		unsigned long long generation = 0;
+	};
+
 	const std::string SEPARATORS = "0123456789 ,;:.!()[]{}-\"#$%^&";
-	WordList m_dictionary;
-	Translator m_translator;
+	//only read and replaced with std::atomic_load and std::atomic_store
+	std::shared_ptr<Dictionary> m_dictionary;
+	//changes (loads included) go one at a time. the settings are for the next load
+	std::mutex m_changeMutex;
+	bool m_isLazy;
+	std::ostream* m_tableStatsOutput;
 	Tokenizer m_tokenizer;
-	std::list<std::string> m_stackOfWordsUsed;
-	//use as stack, so only push_front(), and pop_front()
-
-	//returns the string out of v with the most unkown letters after translation
-	std::string getWordWMostLettersWNoTranslation(std::vector<std::string> v);
-	//returns vector holding all words that are fully translated after translation
-	std::vector<std::string> getFullyTranslatedWords(std::string ciphertext);		
-	//returns true if all characters are known, false if otherwise
-	bool isFullyTranslated(std::string plainTextTranslation);						
+	ResultCache m_cache;
+	//portfolio wins (and their time in microseconds) by index into WORD_ORDERS, along with where to log each race.
+	//several cracks can finish a race at once, so they're only touched with the mutex held
+	mutable std::mutex m_portfolioMutex;
+	mutable long long m_portfolioWins[NUM_WORD_ORDERS];
+	mutable long long m_portfolioWinMicroseconds[NUM_WORD_ORDERS];
+	std::ostream* m_portfolioLog;
+
+	//everything one crack() changes as it searches. each call has its own, so several can run at once
+	struct SearchState
+	{
+		const WordList* dictionary;
+		LetterKey key;
+		CandidateMemo* memo;
+		CrackWordOrder wordOrder;
+		//set by another thread when a portfolio search has lost its race (nullptr outside a portfolio)
+		const std::atomic<bool>* isCancelled;
+		//isWordUsed[w] is true while word w of the problem is the one being tried at some level of the search
+		std::vector<bool> isWordUsed;
+		//isWordCrib[w] is true while word w is translated by a crib, so it doesn't have to be in the dictionary
+		std::vector<bool> isWordCrib;
+		//for CrackOptions::maxMissedWords: isWordSkipped[w] is true while word w is given up on (it has to end up
+		//not being a dictionary word, or the same solution comes from trying its candidates). numMisses counts the
+		//skipped words and the words that were finished as non-words, repeats included
+		std::vector<bool> isWordSkipped;
+		int numMisses;
+		int maxMisses;
+		//the letters that have to be mapped, and the characters that never translate, in words that aren't skipped
+		unsigned int requiredMask;
+		int numUntranslatable;
+		//the key of each solution found (the caller turns them into plaintext, giving each key back as it goes)
+		KeyList solutions;
+		std::chrono::steady_clock::time_point deadline;
+		bool hasDeadline;
+		int maxSolutions;
+		bool timedOut;
+		bool hitSolutionLimit;
+		//counts calls so the clock is only read every so often
+		unsigned int numCalls;
+		long long numNodes;
+		long long maxNodes;
+		//for CrackOptions::anytime: the key that has translated the most of the message into real words so far
+		//(counting repeats of a word), and how many words that was. bestScore is -1 until there is one
+		bool trackBest;
+		LetterKey bestKey;
+		int bestScore;
+	};
+
+	//the keys that solve the message (unsorted), along with result's flags and counters. cipherWords are the
+	//message's words as the tokenizer split them. the search stops early (as if it timed out) once isCancelled is set
+	void findKeys(const WordList& dictionary, const std::string& ciphertext, const std::vector<std::string>& cipherWords, const CrackOptions& options,
+		KeyList& keys, CrackResult& result, const std::atomic<bool>* isCancelled = nullptr) const;
+	//runs findKeys once per word order, each on its own thread, and keeps what the first to finish found
+	void raceWordOrders(const WordList& dictionary, const std::string& ciphertext, const std::vector<std::string>& cipherWords, const CrackOptions& options,
+		KeyList& keys, CrackResult& result) const;
+	//tries to solve the message from samples of its distinct words (see CrackOptions::sampleWords), filling
+	//keys and result's flags and counters. returns false if the sample would have to be the whole message
+	bool crackFromSample(const WordList& dictionary, const std::vector<std::string>& cipherWords, const CrackOptions& options,
+		std::chrono::steady_clock::time_point start, KeyList& keys, CrackResult& result, const std::atomic<bool>* isCancelled) const;
+	//returns the message's distinct (lowercased) words in the order samples take them: first enough to cover
+	//every letter of the message (numToCover of them), then the rest. words with more distinct letters come first
+	static std::vector<std::string> getSampleOrder(const std::vector<std::string>& cipherWords, int& numToCover);
+	//sets up state for searching problem under options and runs the search, leaving the keys it found in state.solutions.
+	//the fixed letters and the cribs with a position go into the key first, then each crib without one is tried
+	//on every word it fits, as the top level of the search
+	void runSearch(const WordList& dictionary, const PreparedProblem& problem, const CrackOptions& options, CandidateMemo& memo, SearchState& state,
+		const std::atomic<bool>* isCancelled = nullptr) const;
+	//places cribs[i] and the ones after it on every word each fits, searching from each complete placement
+	void placeCribs(const PreparedProblem& problem, const std::vector<const CrackCrib*>& cribs, unsigned int i, SearchState& state) const;
+	//searches from state.key, which might already be a solution
+	void searchFrom(const PreparedProblem& problem, SearchState& state) const;
+	//maps the word's letters to the crib's. returns false if the crib doesn't fit the word or the key
+	//(the key may be left partly changed then)
+	static bool applyCrib(const PreparedProblem::Word& word, const std::string& crib, LetterKey& key);
+	//the search itself. adds what it finds to state.solutions
+	void crackRecursive(const PreparedProblem& problem, SearchState& state) const;
+	//the same search, taking the words in the plan's order from step on
+	void crackPlanned(const PreparedProblem& problem, const SearchPlan& plan, int step, SearchState& state) const;
+	//returns true if the search has to stop (deadline passed, node budget spent or enough solutions found)
+	bool shouldStop(SearchState& state) const;
+	//makes state.key the best partial key if it translates more of the message than the last best
+	static void rememberIfBest(const PreparedProblem& problem, SearchState& state);
+	//the share of the message's words that the key turns into words in the dictionary
+	static double getTranslatedShare(const WordList& dictionary, const std::vector<std::string>& cipherWords, const LetterKey& key);
+
+	//the current dictionary
+	std::shared_ptr<Dictionary> getDictionary() const { return std::atomic_load(&m_dictionary); }
+	//a copy of the current dictionary to change, sharing the words the change leaves alone
+	std::shared_ptr<Dictionary> copyDictionary() const;
+	//makes a changed copy current, dropping the cached results the changed words could make wrong
+	void publishChange(const std::shared_ptr<Dictionary>& dictionary, const std::vector<std::string>& changedWords);
+
+	//returns the index of the unused word to try next under state.wordOrder, or -1 if none have unknown letters
+	int chooseWord(const PreparedProblem& problem, SearchState& state) const;
+	//returns the index of the unused word with the most unknown letters after translation, or -1 if none have any
+	int getWordWMostLettersWNoTranslation(const PreparedProblem& problem, const SearchState& state) const;
+	//returns the index of the unused word with unknown letters that has the fewest candidates left, or -1 if none have any
+	int getWordWFewestCandidates(const PreparedProblem& problem, SearchState& state) const;
+	//returns the index of the longest unused word with unknown letters, or -1 if none have any
+	int getLongestWordWNoTranslation(const PreparedProblem& problem, const SearchState& state) const;
+	//returns true if every word the newly added cipher letters finished translating is in the dictionary (or is a crib),
+	//except for as many as the miss budget has left. missed is set to how many that was (repeats included)
+	bool areNewlyTranslatedWordsValid(const PreparedProblem& problem, const SearchState& state, unsigned int added, int& missed) const;
+	//returns true if all characters are known (apart from skipped words), false if otherwise
+	bool isFullyTranslated(const SearchState& state) const;
+	//gives up on word w, counting it as a miss, and searches on without it
+	void skipWord(const PreparedProblem& problem, int w, SearchState& state) const;
 };
 
-//creates tokenizer. will allow other members to default construct
+const CrackWordOrder DecrypterImpl::WORD_ORDERS[DecrypterImpl::NUM_WORD_ORDERS] =
+	{ CrackWordOrder::MostUnknownLetters, CrackWordOrder::FewestCandidates, CrackWordOrder::LongestWord };
+
+//creates an empty dictionary, tokenizer and cache. will allow other members to default construct
 DecrypterImpl::DecrypterImpl()	
-	: m_tokenizer(SEPARATORS)
+	: m_dictionary(std::make_shared<Dictionary>()), m_isLazy(false), m_tableStatsOutput(nullptr), m_tokenizer(SEPARATORS), m_cache(DEFAULT_CACHE_CAPACITY),
+	m_portfolioWins(), m_portfolioWinMicroseconds(), m_portfolioLog(nullptr)
 {}
 
-//O(W), W = number of words in file
+void DecrypterImpl::setLazyLoading(bool lazy)
+{
+	std::lock_guard<std::mutex> change(m_changeMutex);
+	m_isLazy = lazy;
+}
+
+void DecrypterImpl::setTableStatsOutput(std::ostream* out)
+{
+	std::lock_guard<std::mutex> change(m_changeMutex);
+	m_tableStatsOutput = out;
+}
+
+//O(1)
+std::vector<CrackPortfolioStats> DecrypterImpl::getPortfolioStats() const
+{
+	std::lock_guard<std::mutex> lock(m_portfolioMutex);
+	std::vector<CrackPortfolioStats> stats;
+	for (int o = 0; o < NUM_WORD_ORDERS; o++)
+	{
+		CrackPortfolioStats orderStats = { WORD_ORDERS[o], m_portfolioWins[o], m_portfolioWinMicroseconds[o] };
+		stats.push_back(orderStats);
+	}
+	return stats;
+}
+
+void DecrypterImpl::setPortfolioLog(std::ostream* out)
+{
+	std::lock_guard<std::mutex> lock(m_portfolioMutex);
+	m_portfolioLog = out;
+}
+
+//what the portfolio log calls each word order
+static const char* getWordOrderName(CrackWordOrder order)
+{
+	switch (order)
+	{
+	case CrackWordOrder::FewestCandidates:
+		return "fewest candidates";
+	case CrackWordOrder::LongestWord:
+		return "longest word";
+	default:
+		return "most unknown letters";
+	}
+}
+
+//O(W), W = number of words in file. cracks keep going with the old word list while the new one is built
 bool DecrypterImpl::load(std::string filename)	
 {
-	return m_dictionary.loadWordList(filename);
+	std::lock_guard<std::mutex> change(m_changeMutex);
+	std::shared_ptr<Dictionary> dictionary = std::make_shared<Dictionary>();
+	dictionary->words.setLazyLoading(m_isLazy);
+	dictionary->words.setTableStatsOutput(m_tableStatsOutput);
+	//a list that doesn't load leaves the old one in use
+	if (!dictionary->words.loadWordList(filename))
+		return false;
+	dictionary->generation = getDictionary()->generation + 1;
+
+	//solutions found with the old word list might not be right anymore. the cache stops taking them first,
+	//so a crack that's still using it can't put one back in after the swap
+	m_cache.startGeneration(dictionary->generation);
+	std::atomic_store(&m_dictionary, dictionary);
+	return true;
+}
+
+//O(L + B + K + cache), L = length of word, B = words with its pattern, K = changes not yet merged into its length's tables
+bool DecrypterImpl::addWord(const std::string& word)
+{
+	std::lock_guard<std::mutex> change(m_changeMutex);
+	std::shared_ptr<Dictionary> dictionary = copyDictionary();
+	if (!dictionary->words.addWord(word))
+		return false;
+	publishChange(dictionary, std::vector<std::string>(1, word));
+	return true;
+}
+
+//O(L + B + K + cache), like addWord
+bool DecrypterImpl::removeWord(const std::string& word)
+{
+	std::lock_guard<std::mutex> change(m_changeMutex);
+	std::shared_ptr<Dictionary> dictionary = copyDictionary();
+	if (!dictionary->words.removeWord(word))
+		return false;
+	publishChange(dictionary, std::vector<std::string>(1, word));
+	return true;
+}
+
+//O(D + C * B + K + cache), D = size of the file, C = number of changes, B = words with a changed word's pattern,
+//K = changes not yet merged into the tables of the lengths it changes. the copy is paid once for the whole file
+int DecrypterImpl::applyDelta(const std::string& filename)
+{
+	std::lock_guard<std::mutex> change(m_changeMutex);
+	std::shared_ptr<Dictionary> dictionary = copyDictionary();
+	std::vector<std::string> changedWords;
+	int numChanged = dictionary->words.applyDelta(filename, &changedWords);
+	if (numChanged > 0)
+		publishChange(dictionary, changedWords);
+	return numChanged;
+}
+
+//O(S), S = number of word lengths
+std::shared_ptr<DecrypterImpl::Dictionary> DecrypterImpl::copyDictionary() const
+{
+	std::shared_ptr<Dictionary> current = getDictionary();
+	std::shared_ptr<Dictionary> dictionary = std::make_shared<Dictionary>();
+	dictionary->words.copyFrom(current->words);
+	dictionary->generation = current->generation;
+	return dictionary;
+}
+
+//O(C + N), C = number of changed words, N = length of every cached message
+void DecrypterImpl::publishChange(const std::shared_ptr<Dictionary>& dictionary, const std::vector<std::string>& changedWords)
+{
+	//a word only ever stands in for cipher words with its pattern, so only messages with one of those can change.
+	//as with a load, the cache stops taking results from the old words before the swap
+	MyHash<std::string, bool> patterns;
+	for (unsigned int w = 0; w < changedWords.size(); w++)
+		patterns.associate(EnglishLetters::getLetterPattern(changedWords[w]), true);
+	dictionary->generation++;
+	m_cache.startGeneration(dictionary->generation, patterns, m_tokenizer);
+	std::atomic_store(&m_dictionary, dictionary);
+}
+
+//options, with the deadline moved up by however much of it has gone by since start
+static CrackOptions getRemainingOptions(const CrackOptions& options, std::chrono::steady_clock::time_point start)
+{
+	CrackOptions remaining = options;
+	if (options.deadlineInMilliseconds > 0)
+	{
+		long long elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+		//1 ms rather than 0, since 0 would mean no deadline
+		remaining.deadlineInMilliseconds = static_cast<int>(std::max(1LL, options.deadlineInMilliseconds - elapsed));
+	}
+	return remaining;
+}
+
+//O(N) if the message or a relabeled variant is cached, N = length of message
+CrackResult DecrypterImpl::crack(const std::string& ciphertext, const CrackOptions& options)
+{
+	//held through the cache too, which only takes the result if these are still the current words
+	std::shared_ptr<Dictionary> dictionary = getDictionary();
+	CrackResult result;
+	//hints change the answer, but not the cache's key, so hinted cracks skip the cache
+	bool hasHints = !options.fixedKey.empty() || !options.cribs.empty() || options.maxMissedWords > 0;
+	if (!hasHints && m_cache.lookup(ciphertext, dictionary->generation, result.solutions))
+	{
+		result.fromCache = true;
+		if (options.maxSolutions > 0 && result.solutions.size() > static_cast<std::size_t>(options.maxSolutions))
+		{
+			result.solutions.resize(options.maxSolutions);
+			result.hitSolutionLimit = true;
+		}
+		return result;
+	}
+
+	KeyList keys;
+	findKeys(dictionary->words, ciphertext, m_tokenizer.tokenize(ciphertext), options, keys, result);
+	//translate and alphabetize the solutions. each key goes as soon as it's translated, so the keys and the
+	//plaintexts are never both held in full
+	result.solutions.reserve(keys.size());
+	while (!keys.empty())
+	{
+		result.solutions.push_back(keys.back().translate(ciphertext));
+		keys.pop_back();
+	}
+	std::sort(result.solutions.begin(), result.solutions.end());
+
+	//only a finished search has all the solutions, so only those are worth remembering
+	if (!result.timedOut && !result.hitSolutionLimit && !hasHints)
+		m_cache.insert(ciphertext, dictionary->generation, result.solutions);
+	return result;
+}
+
+//O(K log K) past the search, K = number of keys. nothing gets translated, so a long message costs no more
+//per solution than a short one
+CrackKeysResult DecrypterImpl::crackKeys(const std::string& ciphertext, const CrackOptions& options)
+{
+	std::shared_ptr<Dictionary> dictionary = getDictionary();
+	KeyList keys;
+	CrackResult search;
+	findKeys(dictionary->words, ciphertext, m_tokenizer.tokenize(ciphertext), options, keys, search);
+	CrackKeysResult result;
+	result.keys.reserve(keys.size());
+	while (!keys.empty())
+	{
+		result.keys.push_back(keys.back().getKey());
+		keys.pop_back();
+	}
+	std::sort(result.keys.begin(), result.keys.end());
+	result.timedOut = search.timedOut;
+	result.hitSolutionLimit = search.hitSolutionLimit;
+	result.isPartial = search.isPartial;
+	result.partialScore = search.partialScore;
+	result.sampledWords = search.sampledWords;
+	result.searchNodes = search.searchNodes;
+	result.wordOrder = search.wordOrder;
+	return result;
+}
+
+void DecrypterImpl::findKeys(const WordList& dictionary, const std::string& ciphertext, const std::vector<std::string>& cipherWords, const CrackOptions& options,
+	KeyList& keys, CrackResult& result, const std::atomic<bool>* isCancelled) const
+{
+	if (options.portfolio)
+	{
+		raceWordOrders(dictionary, ciphertext, cipherWords, options, keys, result);
+		return;
+	}
+	result.wordOrder = options.wordOrder;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	//a long message can usually be solved from a few of its words, and the rest only checked
+	if (options.sampleWords <= 0 || !options.cribs.empty() || options.maxMissedWords > 0 || !crackFromSample(dictionary, cipherWords, options, start, keys, result, isCancelled))
+	{
+		//boil the message down once, so the search only does mask checks and dictionary lookups
+		PreparedProblem problem(ciphertext, cipherWords, dictionary);
+
+		CandidateMemo memo(problem);
+		SearchState state;
+		runSearch(dictionary, problem, getRemainingOptions(options, start), memo, state, isCancelled);
+		keys = std::move(state.solutions);
+		result.searchNodes += state.numNodes;
+		result.timedOut = state.timedOut;
+		result.hitSolutionLimit = state.hitSolutionLimit;
+		result.candidateListLookups += memo.getNumLookups();
+		result.candidateListHits += memo.getNumHits();
+		if (keys.empty() && state.timedOut && state.bestScore >= 0)
+		{
+			keys.push_back(state.bestKey);
+			result.isPartial = true;
+		}
+	}
+	if (result.isPartial)
+		result.partialScore = getTranslatedShare(dictionary, cipherWords, keys[0]);
+}
+
+//O(T * search) work over T threads, T = NUM_WORD_ORDERS, but it takes only as long as the fastest search
+void DecrypterImpl::raceWordOrders(const WordList& dictionary, const std::string& ciphertext, const std::vector<std::string>& cipherWords, const CrackOptions& options,
+	KeyList& keys, CrackResult& result) const
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	//the dictionary is only read while searching, so the racers share it. each has its own problem and memo
+	std::atomic<bool> isDone(false);
+	std::mutex winnerMutex;
+	int winner = -1;
+	std::vector<std::thread> racers;
+	for (int o = 0; o < NUM_WORD_ORDERS; o++)
+	{
+		racers.push_back(std::thread([&, o]()
+		{
+			CrackOptions racerOptions = options;
+			racerOptions.portfolio = false;
+			racerOptions.wordOrder = WORD_ORDERS[o];
+			KeyList racerKeys;
+			CrackResult racerResult;
+			findKeys(dictionary, ciphertext, cipherWords, racerOptions, racerKeys, racerResult, &isDone);
+
+			//the first one back wins, and tells the rest to stop. what they found by then is thrown away
+			std::lock_guard<std::mutex> lock(winnerMutex);
+			if (winner >= 0)
+				return;
+			winner = o;
+			keys = std::move(racerKeys);
+			result = racerResult;
+			isDone = true;
+		}));
+	}
+	for (unsigned int r = 0; r < racers.size(); r++)
+		racers[r].join();
+
+	long long microseconds = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+	std::lock_guard<std::mutex> lock(m_portfolioMutex);
+	m_portfolioWins[winner]++;
+	m_portfolioWinMicroseconds[winner] += microseconds;
+	if (m_portfolioLog != nullptr)
+		*m_portfolioLog << "portfolio: " << getWordOrderName(WORD_ORDERS[winner]) << " won in " << microseconds << " us ("
+			<< m_portfolioWins[winner] << " wins)" << std::endl;
+}
+
+//O(S * search + K * W * L), S = number of sample sizes tried, K = keys the last sample left, W = distinct words
+bool DecrypterImpl::crackFromSample(const WordList& dictionary, const std::vector<std::string>& cipherWords, const CrackOptions& options,
+	std::chrono::steady_clock::time_point start, KeyList& keys, CrackResult& result, const std::atomic<bool>* isCancelled) const
+{
+	int numToCover = 0;
+	std::vector<std::string> words = getSampleOrder(cipherWords, numToCover);
+	//a literal '?' never translates, so there's nothing for a sample to find
+	for (unsigned int w = 0; w < words.size(); w++)
+		if (words[w].find(EnglishLetters::UNKNOWN) != std::string::npos)
+			return false;
+
+	//the sample always covers every letter, so each key it leaves is a whole key for the message
+	for (std::size_t sampleSize = std::max(options.sampleWords, numToCover); sampleSize < words.size(); sampleSize *= 2)
+	{
+		std::vector<std::string> sample(words.begin(), words.begin() + sampleSize);
+		PreparedProblem problem(std::string(), sample, dictionary);
+		CandidateMemo memo(problem);
+		SearchState state;
+		CrackOptions sampleOptions = getRemainingOptions(options, start);
+		sampleOptions.maxSolutions = MAX_SAMPLE_KEYS;
+		runSearch(dictionary, problem, sampleOptions, memo, state, isCancelled);
+		result.searchNodes += state.numNodes;
+		result.candidateListLookups += memo.getNumLookups();
+		result.candidateListHits += memo.getNumHits();
+		result.sampledWords = static_cast<int>(sampleSize);
+
+		//too many keys left open means the sample doesn't say enough yet, unless time's up to make it bigger
+		if (state.hitSolutionLimit && !state.timedOut)
+			continue;
+
+		//check each key against the words outside the sample in one pass (the search checked the ones in it)
+		keys.clear();
+		for (unsigned int k = 0; k < state.solutions.size(); k++)
+		{
+			bool isValid = true;
+			for (std::size_t w = sampleSize; w < words.size() && isValid; w++)
+				isValid = dictionary.contains(state.solutions[k].translate(words[w]));
+			if (isValid)
+				keys.push_back(state.solutions[k]);
+		}
+		result.timedOut = state.timedOut;
+		if (keys.empty() && state.timedOut && state.bestScore >= 0)
+		{
+			keys.push_back(state.bestKey);
+			result.isPartial = true;
+		}
+		if (options.maxSolutions > 0 && keys.size() > static_cast<std::size_t>(options.maxSolutions))
+		{
+			keys.resize(options.maxSolutions);
+			result.hitSolutionLimit = true;
+		}
+		return true;
+	}
+	return false;
+}
+
+//O(W * SIZE + W log W), W = number of distinct words
+std::vector<std::string> DecrypterImpl::getSampleOrder(const std::vector<std::string>& cipherWords, int& numToCover)
+{
+	//the distinct words, lowercased, with the letters each one has
+	struct SampleWord
+	{
+		std::string text;
+		unsigned int cipherMask;
+		int numLetters;
+	};
+	std::vector<SampleWord> words;
+	MyHash<std::string, bool> isWordSeen;
+	unsigned int messageMask = 0;
+	for (unsigned int t = 0; t < cipherWords.size(); t++)
+	{
+		SampleWord word = { std::string(), 0, 0 };
+		for (unsigned int i = 0; i < cipherWords[t].size(); i++)
+		{
+			word.text += EnglishLetters::toLower(cipherWords[t][i]);
+			int cipherIndex = EnglishLetters::indexOf(cipherWords[t][i]);
+			if (cipherIndex != EnglishLetters::NOT_A_LETTER && !(word.cipherMask & (1u << cipherIndex)))
+			{
+				word.cipherMask |= 1u << cipherIndex;
+				word.numLetters++;
+			}
+		}
+		if (isWordSeen.find(word.text) != nullptr)
+			continue;
+		isWordSeen.associate(word.text, true);
+		messageMask |= word.cipherMask;
+		words.push_back(word);
+	}
+
+	//a word with more distinct letters usually has fewer candidates and pins down more of the key
+	std::sort(words.begin(), words.end(), [](const SampleWord& a, const SampleWord& b)
+	{
+		if (a.numLetters != b.numLetters)
+			return a.numLetters > b.numLetters;
+		if (a.text.size() != b.text.size())
+			return a.text.size() > b.text.size();
+		return a.text < b.text;
+	});
+
+	//first keep taking the word that adds the most letters not covered yet (at most SIZE times), then the rest in order
+	std::vector<std::string> order;
+	std::vector<bool> isTaken(words.size(), false);
+	unsigned int covered = 0;
+	while (covered != messageMask)
+	{
+		int best = -1;
+		int bestNewLetters = 0;
+		for (unsigned int w = 0; w < words.size(); w++)
+		{
+			unsigned int newLetters = words[w].cipherMask & ~covered;
+			int numNewLetters = 0;
+			for (; newLetters != 0; newLetters &= newLetters - 1)
+				numNewLetters++;
+			if (!isTaken[w] && numNewLetters > bestNewLetters)
+			{
+				best = w;
+				bestNewLetters = numNewLetters;
+			}
+		}
+		isTaken[best] = true;
+		covered |= words[best].cipherMask;
+		order.push_back(words[best].text);
+	}
+	numToCover = static_cast<int>(order.size());
+	for (unsigned int w = 0; w < words.size(); w++)
+		if (!isTaken[w])
+			order.push_back(words[w].text);
+	return order;
+}
+
+//cracks every message at once as one message: the words of all of them go into one problem, so they
+//all constrain the one key the search builds. it goes through findKeys like crack() does, so sampling,
+//portfolios and anytime cracks work the same way
+JointCrackResult DecrypterImpl::crackJoint(const std::vector<std::string>& ciphertexts, const CrackOptions& options)
+{
+	std::shared_ptr<Dictionary> dictionary = getDictionary();
+	JointCrackResult result;
+	std::vector<std::string> cipherWords;
+	std::string allCiphertexts;
+	for (unsigned int m = 0; m < ciphertexts.size(); m++)
+	{
+		std::vector<std::string> words = m_tokenizer.tokenize(ciphertexts[m]);
+		cipherWords.insert(cipherWords.end(), words.begin(), words.end());
+		allCiphertexts += ciphertexts[m];
+		allCiphertexts += '\n';
+	}
+	KeyList keys;
+	CrackResult search;
+	findKeys(dictionary->words, allCiphertexts, cipherWords, options, keys, search);
+	//each key decrypts every message (and goes once it has, like in crack()). order the solutions by their plaintexts
+	result.solutions.reserve(keys.size());
+	while (!keys.empty())
+	{
+		JointSolution solution;
+		solution.key = keys.back().getKey();
+		for (unsigned int m = 0; m < ciphertexts.size(); m++)
+			solution.plaintexts.push_back(keys.back().translate(ciphertexts[m]));
+		result.solutions.push_back(std::move(solution));
+		keys.pop_back();
+	}
+	std::sort(result.solutions.begin(), result.solutions.end(), [](const JointSolution& a, const JointSolution& b)
+	{
+		return a.plaintexts < b.plaintexts;
+	});
+	result.timedOut = search.timedOut;
+	result.hitSolutionLimit = search.hitSolutionLimit;
+	result.isPartial = search.isPartial;
+	result.partialScore = search.partialScore;
+	result.sampledWords = search.sampledWords;
+	result.searchNodes = search.searchNodes;
+	result.wordOrder = search.wordOrder;
+	return result;
+}
+
+//O(W^2 * P), W = number of distinct words, P = distinct letters in each
+void DecrypterImpl::explainPlan(const std::string& ciphertext, const CrackOptions& options, std::ostream& out) const
+{
+	std::shared_ptr<Dictionary> dictionary = getDictionary();
+	PreparedProblem problem(ciphertext, m_tokenizer.tokenize(ciphertext), dictionary->words);
+	if (!SearchPlan::canPlan(options.wordOrder) || options.maxMissedWords > 0 || options.portfolio)
+	{
+		out << "no plan: the search picks its words as it goes with these options" << std::endl;
+		return;
+	}
+
+	//the letters known before the search starts, as runSearch sets them up (cribs without a position
+	//are placed by the search itself, and each placement gets its own plan)
+	LetterKey key;
+	std::vector<bool> isWordCrib(problem.getNumWords(), false);
+	for (int i = 0; i < EnglishLetters::SIZE && i < static_cast<int>(options.fixedKey.size()); i++)
+	{
+		int plainIndex = EnglishLetters::indexOf(options.fixedKey[i]);
+		if (plainIndex != EnglishLetters::NOT_A_LETTER)
+			key.fix(i, plainIndex);
+	}
+	for (unsigned int c = 0; c < options.cribs.size(); c++)
+	{
+		const CrackCrib& crib = options.cribs[c];
+		if (crib.position < 0 || crib.position >= problem.getNumTokens())
+			continue;
+		int w = problem.getWordOfToken(crib.position);
+		if (applyCrib(problem.getWord(w), crib.plaintext, key))
+			isWordCrib[w] = true;
+	}
+	SearchPlan(problem, options.wordOrder, key.getMappedCipher(), isWordCrib).explain(problem, out);
+}
+
+//O(C * P), C = number of candidates of every word, P = distinct letters in each (plus planning)
+CrackCostEstimate DecrypterImpl::estimateCost(const std::string& ciphertext) const
+{
+	std::shared_ptr<Dictionary> dictionary = getDictionary();
+	PreparedProblem problem(ciphertext, m_tokenizer.tokenize(ciphertext), dictionary->words);
+	SearchPlan plan(problem, CrackWordOrder::MostUnknownLetters, 0, std::vector<bool>(problem.getNumWords(), false));
+	CrackCostEstimate estimate;
+	plan.estimate(problem, estimate.searchNodes, estimate.solutions);
+	estimate.numCipherLetters = 0;
+	for (unsigned int mask = problem.getMessageMask(); mask != 0; mask &= mask - 1)
+		estimate.numCipherLetters++;
+	estimate.numDistinctWords = problem.getNumWords();
+	estimate.numSteps = plan.getNumSteps();
+	//a word that can't be translated ends every branch, and a word with no letters that isn't a word ends the
+	//search before it starts
+	if (!problem.canBeFullyTranslated())
+		estimate.solutions = 0;
+	for (int w = 0; w < problem.getNumWords(); w++)
+	{
+		if (problem.getWord(w).cipherMask == 0 && !dictionary->words.contains(problem.getWord(w).text))
+		{
+			estimate.searchNodes = 0;
+			estimate.solutions = 0;
+		}
+	}
+	return estimate;
+}
+
+void DecrypterImpl::runSearch(const WordList& dictionary, const PreparedProblem& problem, const CrackOptions& options, CandidateMemo& memo, SearchState& state,
+	const std::atomic<bool>* isCancelled) const
+{
+	state.dictionary = &dictionary;
+	state.memo = &memo;
+	state.wordOrder = options.wordOrder;
+	state.isCancelled = isCancelled;
+	state.isWordUsed.assign(problem.getNumWords(), false);
+	state.hasDeadline = options.deadlineInMilliseconds > 0;
+	state.deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.deadlineInMilliseconds);
+	state.maxSolutions = options.maxSolutions;
+	state.timedOut = false;
+	state.hitSolutionLimit = false;
+	state.numCalls = 0;
+	state.numNodes = 0;
+	state.maxNodes = options.maxSearchNodes;
+	state.trackBest = options.anytime;
+	state.bestScore = -1;
+	state.isWordCrib.assign(problem.getNumWords(), false);
+	state.isWordSkipped.assign(problem.getNumWords(), false);
+	state.numMisses = 0;
+	state.maxMisses = options.maxMissedWords;
+	state.requiredMask = problem.getMessageMask();
+	state.numUntranslatable = problem.canBeFullyTranslated() ? 0 : 1;
+	if (problem.getMessageMask() == 0)
+		return;
+
+	//the letters we were told, skipping unknowns. two cipher letters can't share a plain letter
+	for (int i = 0; i < EnglishLetters::SIZE && i < static_cast<int>(options.fixedKey.size()); i++)
+	{
+		int plainIndex = EnglishLetters::indexOf(options.fixedKey[i]);
+		if (plainIndex != EnglishLetters::NOT_A_LETTER && !state.key.fix(i, plainIndex))
+			return;
+	}
+
+	//then the cribs whose word we know, saving the others for the search
+	std::vector<const CrackCrib*> floatingCribs;
+	for (unsigned int c = 0; c < options.cribs.size(); c++)
+	{
+		const CrackCrib& crib = options.cribs[c];
+		if (crib.position < 0)
+		{
+			floatingCribs.push_back(&crib);
+			continue;
+		}
+		if (crib.position >= problem.getNumTokens())
+			return;
+		int w = problem.getWordOfToken(crib.position);
+		if (!applyCrib(problem.getWord(w), crib.plaintext, state.key))
+			return;
+		state.isWordCrib[w] = true;
+	}
+
+	//words with no letters at all are as translated as they'll ever be, so they have to be real words already,
+	//and so do the words the hints just translated
+	int missed = 0;
+	if (!areNewlyTranslatedWordsValid(problem, state, 0, missed))
+		return;
+	state.numMisses += missed;
+	if (!areNewlyTranslatedWordsValid(problem, state, state.key.getMappedCipher(), missed))
+		return;
+	state.numMisses += missed;
+	if (state.trackBest)
+		rememberIfBest(problem, state);
+	placeCribs(problem, floatingCribs, 0, state);
+}
+
+//O(W^K * search), W = number of distinct words, K = number of cribs
+void DecrypterImpl::placeCribs(const PreparedProblem& problem, const std::vector<const CrackCrib*>& cribs, unsigned int i, SearchState& state) const
+{
+	if (i == cribs.size())
+	{
+		searchFrom(problem, state);
+		return;
+	}
+	//try the crib as each word of the message, keeping the key to go back to after each
+	for (int w = 0; w < problem.getNumWords(); w++)
+	{
+		LetterKey saved = state.key;
+		bool wasCrib = state.isWordCrib[w];
+		if (applyCrib(problem.getWord(w), cribs[i]->plaintext, state.key))
+		{
+			state.isWordCrib[w] = true;
+			int missed = 0;
+			if (areNewlyTranslatedWordsValid(problem, state, state.key.getMappedCipher() & ~saved.getMappedCipher(), missed))
+			{
+				state.numMisses += missed;
+				if (state.trackBest)
+					rememberIfBest(problem, state);
+				placeCribs(problem, cribs, i + 1, state);
+				state.numMisses -= missed;
+			}
+		}
+		state.key = saved;
+		state.isWordCrib[w] = wasCrib;
+		if (shouldStop(state))
+			break;
+	}
+}
+
+void DecrypterImpl::searchFrom(const PreparedProblem& problem, SearchState& state) const
+{
+	//the hints might have translated the whole message already
+	if (isFullyTranslated(state))
+		state.solutions.push_back(state.key);
+	//skipping a word changes which letters are known further down, so only a search without misses follows a plan
+	else if (SearchPlan::canPlan(state.wordOrder) && state.maxMisses == 0)
+		crackPlanned(problem, SearchPlan(problem, state.wordOrder, state.key.getMappedCipher(), state.isWordCrib), 0, state);
+	else
+		crackRecursive(problem, state);
+}
+
+//O(L), L = length of word
+bool DecrypterImpl::applyCrib(const PreparedProblem::Word& word, const std::string& crib, LetterKey& key)
+{
+	if (crib.size() != word.text.size())
+		return false;
+	//letters have to go to letters (the key keeps it one to one), and anything else has to match exactly
+	for (unsigned int i = 0; i < crib.size(); i++)
+	{
+		int cipherIndex = EnglishLetters::indexOf(word.text[i]);
+		int plainIndex = EnglishLetters::indexOf(crib[i]);
+		if (cipherIndex == EnglishLetters::NOT_A_LETTER)
+		{
+			if (word.text[i] != crib[i] || word.text[i] == EnglishLetters::UNKNOWN)
+				return false;
+		}
+		else if (plainIndex == EnglishLetters::NOT_A_LETTER || !key.fix(cipherIndex, plainIndex))
+			return false;
+	}
+	return true;
+}
+
+//O(1)
+bool DecrypterImpl::shouldStop(SearchState& state) const
+{
+	if (state.timedOut || state.hitSolutionLimit)
+		return true;
+	if (state.maxSolutions > 0 && state.solutions.size() >= static_cast<std::size_t>(state.maxSolutions))
+		state.hitSolutionLimit = true;
+	else if (state.maxNodes > 0 && state.numNodes >= state.maxNodes)
+		state.timedOut = true;
+	//a portfolio search that lost stops like one that ran out of time. nobody looks at what it found
+	else if (state.isCancelled != nullptr && state.isCancelled->load(std::memory_order_relaxed))
+		state.timedOut = true;
+	//reading the clock costs about as much as a small step of the search, so only do it every 16 calls
+	else if (state.hasDeadline && (state.numCalls++ & 15) == 0 && std::chrono::steady_clock::now() >= state.deadline)
+		state.timedOut = true;
+	return state.timedOut || state.hitSolutionLimit;
 }
 
-std::vector<std::string> DecrypterImpl::crack(const std::string& ciphertext)
+void DecrypterImpl::crackRecursive(const PreparedProblem& problem, SearchState& state) const
 {
-	//vector to build and return
-	std::vector<std::string> toReturn;	
-	//creates a vector which holds all cipher words in the text
-	std::vector<std::string> vectorOfAllCipherWords = m_tokenizer.tokenize(ciphertext);	
+	//if time is up or there are enough solutions, give up on this branch
+	if (shouldStop(state))
+		return;
+	state.numNodes++;
 
 	//gets word with the most unknown letters after translation that hasn't already been chosen
-	std::string w = getWordWMostLettersWNoTranslation(vectorOfAllCipherWords);	
-	//gets translation of this word
-	std::string translationOfW = m_translator.getTranslation(w);				
+	int w = chooseWord(problem, state);
+	if (w < 0)
+		return;
+	const PreparedProblem::Word& word = problem.getWord(w);
+	state.isWordUsed[w] = true;
 
 	//gets C, a collection of possible words that w could be given our current translation mapping
-	std::vector<std::string> C = m_dictionary.findCandidates(w, translationOfW);	
-
-	//if there are no possible words with current translation, take that word off the stack, throw out mapping and return recursive call empty
-	if (C.empty())							
-	{										
-		m_stackOfWordsUsed.pop_front();		
-		m_translator.popMapping();			
-		return std::vector<std::string>();		
-	}										
+	std::vector<int> scratch;
+	CandidateSpan C = state.memo->getCandidates(w, state.key, scratch);
 
 	//for each possible word p in C
-	for (int i = 0; i < C.size(); i++)		
+	for (int i = 0; i < C.size; i++)
 	{
 		//if the mapping from w to p would be incompatible with the current mapping go to next p
-		if (!m_translator.pushMapping(w, C[i]))	 
-			continue;							
-											
-		//use new translation to translate entire message
-		std::string translationOfEntireCipherText = m_translator.getTranslation(ciphertext);	
-		//get all fully translated words using new/current translation mapping
-		std::vector<std::string> allFullyTranslatedWords = getFullyTranslatedWords(ciphertext);	
-
-		bool wordIsFound;
-		//for each fully-translated word
-		for (int j = 0; j < allFullyTranslatedWords.size(); j++)	
-		{
-			wordIsFound = true;
-			//if any one fully-translated word is not found in the dictionary
-			if (!m_dictionary.contains(allFullyTranslatedWords[j]))	
-			{
-				//get rid of the current, incorrect mapping, set this to false to go to next p, and end loop through translated words
-				m_translator.popMapping();	
-				wordIsFound = false;		
-				break;						
-			}
+		const PreparedProblem::Candidate& candidate = word.candidates[C.indexes[i]];
+		if (!state.key.isCompatible(word, candidate))
+			continue;
+		unsigned int added = state.key.apply(word, candidate);
+
+		//only go on if every word this mapping just finished translating is an english word (or the misses allow it)
+		int missed = 0;
+		if (areNewlyTranslatedWordsValid(problem, state, added, missed))
+		{
+			state.numMisses += missed;
+			if (state.trackBest)
+				rememberIfBest(problem, state);
+			//if the message has not been fully translated, recursively call step 2 with the new mapping
+			if (!isFullyTranslated(state))
+				crackRecursive(problem, state);
+			//if the message is fully translated, record this as a valid solution for eventual output to the user
+			else
+				state.solutions.push_back(state.key);
+			state.numMisses -= missed;
 		}
-		//if any fully-translated word after pushing new translation isn't found, must go to next p immediately
-		if (!wordIsFound)	
-			continue;		
-	
-		//at this point all fully-translated words are valid english words
-		//if the message has not been fully translated
-		if (!isFullyTranslated(m_translator.getTranslation(ciphertext)))	
+
+		//discard this mapping, and stop here if that was the last solution asked for, otherwise go to next p
+		state.key.undo(word, candidate, added);
+		if (shouldStop(state))
+			break;
+	}
+
+	//with misses to spare, w might not be a dictionary word at all
+	if (state.numMisses + word.numOccurrences <= state.maxMisses && !shouldStop(state))
+		skipWord(problem, w, state);
+
+	//Having tried all the words in our collection C, return to the previous recursive call
+	state.isWordUsed[w] = false;
+}
+
+void DecrypterImpl::crackPlanned(const PreparedProblem& problem, const SearchPlan& plan, int step, SearchState& state) const
+{
+	if (shouldStop(state))
+		return;
+	state.numNodes++;
+	if (step == plan.getNumSteps())
+		return;
+	const SearchPlan::Step& planned = plan.getStep(step);
+	const PreparedProblem::Word& word = problem.getWord(planned.word);
+
+	std::vector<int> scratch;
+	CandidateSpan C = state.memo->getCandidates(planned.word, state.key, scratch);
+	for (int i = 0; i < C.size; i++)
+	{
+		const PreparedProblem::Candidate& candidate = word.candidates[C.indexes[i]];
+		if (!state.key.isCompatible(word, candidate))
+			continue;
+		unsigned int added = state.key.apply(word, candidate);
+
+		//the plan already knows which words this step finishes, so only those get looked up
+		bool isValid = true;
+		for (unsigned int c = 0; c < planned.checkedWords.size() && isValid; c++)
+			isValid = state.dictionary->contains(state.key.translate(problem.getWord(planned.checkedWords[c]).text));
+		if (isValid)
 		{
-			//recursively call step 2, passing in our temporary mapping as the new input mapping
-			std::vector<std::string> recursiveResult = crack(ciphertext);
-			//add recursive result to vector to return
-			toReturn.insert(toReturn.end(), recursiveResult.begin(), recursiveResult.end());		
+			if (state.trackBest)
+				rememberIfBest(problem, state);
+			if (!isFullyTranslated(state))
+				crackPlanned(problem, plan, step + 1, state);
+			else
+				state.solutions.push_back(state.key);
 		}
-		//if the message is fully translated
-		else		
+
+		state.key.undo(word, candidate, added);
+		if (shouldStop(state))
+			break;
+	}
+}
+
+//O(W + search)
+void DecrypterImpl::skipWord(const PreparedProblem& problem, int w, SearchState& state) const
+{
+	unsigned int oldRequiredMask = state.requiredMask;
+	int oldNumUntranslatable = state.numUntranslatable;
+	state.isWordSkipped[w] = true;
+	state.numMisses += problem.getWord(w).numOccurrences;
+
+	//its letters only have to be mapped if some other word still needs them
+	state.requiredMask = 0;
+	state.numUntranslatable = 0;
+	for (int v = 0; v < problem.getNumWords(); v++)
+	{
+		if (state.isWordSkipped[v])
+			continue;
+		state.requiredMask |= problem.getWord(v).cipherMask;
+		state.numUntranslatable += problem.getWord(v).numUntranslatable;
+	}
+
+	//nothing new is mapped, so there's nothing new to check
+	if (isFullyTranslated(state))
+		state.solutions.push_back(state.key);
+	else
+		crackRecursive(problem, state);
+
+	state.isWordSkipped[w] = false;
+	state.numMisses -= problem.getWord(w).numOccurrences;
+	state.requiredMask = oldRequiredMask;
+	state.numUntranslatable = oldNumUntranslatable;
+}
+
+//O(W), W = number of distinct words
+void DecrypterImpl::rememberIfBest(const PreparedProblem& problem, SearchState& state)
+{
+	//every fully translated word has already been checked, but only the real words count: not the skipped
+	//ones, nor the ones let through as misses (the rest of numMisses, since those are all fully translated)
+	int score = 0;
+	int numSkipped = 0;
+	for (int w = 0; w < problem.getNumWords(); w++)
+	{
+		if (state.isWordSkipped[w])
+			numSkipped += problem.getWord(w).numOccurrences;
+		else if (state.key.isFullyTranslated(problem.getWord(w)))
+			score += problem.getWord(w).numOccurrences;
+	}
+	score -= state.numMisses - numSkipped;
+	if (score > state.bestScore)
+	{
+		state.bestScore = score;
+		state.bestKey = state.key;
+	}
+}
+
+//O(T * L), T = number of words in the message
+double DecrypterImpl::getTranslatedShare(const WordList& dictionary, const std::vector<std::string>& cipherWords, const LetterKey& key)
+{
+	if (cipherWords.empty())
+		return 0;
+	int numTranslated = 0;
+	for (unsigned int t = 0; t < cipherWords.size(); t++)
+	{
+		std::string translation = key.translate(cipherWords[t]);
+		if (translation.find(EnglishLetters::UNKNOWN) == std::string::npos && dictionary.contains(translation))
+			numTranslated++;
+	}
+	return static_cast<double>(numTranslated) / cipherWords.size();
+}
+
+//O(N), N = length of message (more for FewestCandidates)
+int DecrypterImpl::chooseWord(const PreparedProblem& problem, SearchState& state) const
+{
+	switch (state.wordOrder)
+	{
+	case CrackWordOrder::FewestCandidates:
+		return getWordWFewestCandidates(problem, state);
+	case CrackWordOrder::LongestWord:
+		return getLongestWordWNoTranslation(problem, state);
+	default:
+		return getWordWMostLettersWNoTranslation(problem, state);
+	}
+}
+
+//O(W) candidate list lookups, W = number of distinct words (each O(1) once the memo has the list)
+int DecrypterImpl::getWordWFewestCandidates(const PreparedProblem& problem, SearchState& state) const
+{
+	int fewestCandidates = 0;
+	int indexOfWordWFewestCandidates = -1;
+	std::vector<int> scratch;
+	for (int w = 0; w < problem.getNumWords(); w++)
+	{
+		const PreparedProblem::Word& word = problem.getWord(w);
+		if (state.isWordUsed[w] || ((word.cipherMask & ~state.key.getMappedCipher()) == 0 && word.numUntranslatable == 0))
+			continue;
+		int numCandidates = state.memo->getCandidates(w, state.key, scratch).size;
+		if (indexOfWordWFewestCandidates < 0 || numCandidates < fewestCandidates)
 		{
-			//record this as a valid solution for eventual output to the user
-			toReturn.push_back(m_translator.getTranslation(ciphertext));	
-			//discard this mapping since it got us the result
-			m_translator.popMapping();	
-			//and go to next p
-			continue;					
+			fewestCandidates = numCandidates;
+			indexOfWordWFewestCandidates = w;
 		}
+		//nothing beats a dead end
+		if (numCandidates == 0)
+			break;
 	}
+	return indexOfWordWFewestCandidates;
+}
 
-	//Having tried all the words in our collection C, throw away the current mapping table pop from stack and return to the previous recursive call
-	m_translator.popMapping();
-	m_stackOfWordsUsed.pop_front();
-	//alphabetize vector, and return it
-	std::sort(toReturn.begin(), toReturn.end());	
-	return toReturn;
+//O(W), W = number of distinct words
+int DecrypterImpl::getLongestWordWNoTranslation(const PreparedProblem& problem, const SearchState& state) const
+{
+	int indexOfLongestWord = -1;
+	for (int w = 0; w < problem.getNumWords(); w++)
+	{
+		const PreparedProblem::Word& word = problem.getWord(w);
+		if (state.isWordUsed[w] || ((word.cipherMask & ~state.key.getMappedCipher()) == 0 && word.numUntranslatable == 0))
+			continue;
+		if (indexOfLongestWord < 0 || word.text.size() > problem.getWord(indexOfLongestWord).text.size())
+			indexOfLongestWord = w;
+	}
+	return indexOfLongestWord;
 }
 
-std::string DecrypterImpl::getWordWMostLettersWNoTranslation(std::vector<std::string> v)
+//O(N), N = length of message
+int DecrypterImpl::getWordWMostLettersWNoTranslation(const PreparedProblem& problem, const SearchState& state) const
 {
 	int mostUnknowns = 0;
-	int indexOfWordWMostUnknowns = 0;
-	//for each word in the vector v
-	for (int i = 0; i < v.size(); i++)	
+	int indexOfWordWMostUnknowns = -1;
+	//for each word that hasn't already been used
+	for (int w = 0; w < problem.getNumWords(); w++)
+	{
+		if (state.isWordUsed[w])
+			continue;
+		//count the letters of its translation that are unknown
+		const PreparedProblem::Word& word = problem.getWord(w);
+		unsigned int unknownLetters = word.cipherMask & ~state.key.getMappedCipher();
+		int numUnknowns = word.numUntranslatable;
+		for (unsigned int j = 0; unknownLetters != 0 && j < word.text.size(); j++)
+		{
+			int cipherIndex = EnglishLetters::indexOf(word.text[j]);
+			if (cipherIndex != EnglishLetters::NOT_A_LETTER && (unknownLetters & (1u << cipherIndex)))
+				numUnknowns++;
+		}
+		//if it has the most unknowns so far, save it
+		if (numUnknowns > mostUnknowns)
+		{
+			mostUnknowns = numUnknowns;
+			indexOfWordWMostUnknowns = w;
+		}
+	}
+	return indexOfWordWMostUnknowns;
+}
+
+//O(W * L), W = number of distinct words, L = their length
+bool DecrypterImpl::areNewlyTranslatedWordsValid(const PreparedProblem& problem, const SearchState& state, unsigned int added, int& missed) const
+{
+	const LetterKey& key = state.key;
+	missed = 0;
+	//for each word that uses an added letter (or, if none were added, has no letters) and is now fully translated
+	for (int w = 0; w < problem.getNumWords(); w++)
+	{
+		const PreparedProblem::Word& word = problem.getWord(w);
+		bool isNew = (added == 0) ? word.cipherMask == 0 : (word.cipherMask & added) != 0;
+		if (!isNew || state.isWordCrib[w] || !key.isFullyTranslated(word))
+			continue;
+		//if it isn't found in the dictionary, this mapping is incorrect, unless there are misses left for it.
+		//a skipped word is already counted, but it must not turn out to be a word after all
+		bool isWord = state.dictionary->contains(key.translate(word.text));
+		if (state.isWordSkipped[w])
+		{
+			if (isWord)
+				return false;
+		}
+		else if (!isWord)
+		{
+			missed += word.numOccurrences;
+			if (state.numMisses + missed > state.maxMisses)
+				return false;
+		}
+	}
+	return true;
+}
+
+//O(1)
+bool DecrypterImpl::isFullyTranslated(const SearchState& state) const
+{
+	//every letter of the message has to be mapped, and there can't be characters that never translate
+	return (state.requiredMask & ~state.key.getMappedCipher()) == 0 && state.numUntranslatable == 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////
+//******************** ResultCache functions *********************************
+//////////////////////////////////////////////////////////////////////////////
+
+ResultCache::ResultCache(std::size_t capacityInBytes)
+	: m_capacityInBytes(capacityInBytes), m_bytesUsed(0), m_hits(0), m_misses(0), m_evictions(0), m_generation(0)
+{}
+
+//O(E), E = number of entries evicted. a capacity of 0 turns the cache off
+void ResultCache::setCapacity(std::size_t capacityInBytes)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_capacityInBytes = capacityInBytes;
+	evictUntilUnder(m_capacityInBytes);
+}
+
+//O(N * S), N = length of message, S = number of solutions
+bool ResultCache::lookup(const std::string& ciphertext, unsigned long long generation, std::vector<std::string>& solutions)
+{
+	char cipherToCanonical[EnglishLetters::SIZE];
+	std::string canonical = canonicalize(ciphertext, cipherToCanonical);
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	//a crack still using an old word list can't use what the new one found
+	std::list<Entry>::iterator* found = generation == m_generation ? m_index.find(std::string_view(canonical)) : nullptr;
+	if (found == nullptr)
+	{
+		m_misses++;
+		return false;
+	}
+	m_hits++;
+	//move the entry to the front, since it was just used
+	m_entries.splice(m_entries.begin(), m_entries, *found);
+
+	//rebuild each solution: each cipher letter goes to its relabeled letter, then to that solution's plaintext letter
+	const Entry& entry = **found;
+	const char* keys = entry.keys.data();
+	std::size_t numSolutions = entry.keys.size() / EnglishLetters::SIZE;
+	solutions.clear();
+	solutions.reserve(numSolutions);
+	for (std::size_t s = 0; s < numSolutions; s++)
 	{
-		std::string currWord = v[i];
-		std::string currWordsTranslation = m_translator.getTranslation(currWord);
-		int numUnknowns = 0;
-		//for each letter of this word's translation
-		for (int j = 0; j < currWordsTranslation.size(); j++)	
+		std::string plaintext = ciphertext;
+		for (unsigned int i = 0; i < plaintext.size(); i++)
 		{
-			//if it is unknown, update var
-			if (currWordsTranslation[j] == '?')	
-				numUnknowns++;					
+			int cipherIndex = EnglishLetters::indexOf(plaintext[i]);
+			if (cipherIndex == EnglishLetters::NOT_A_LETTER)
+				continue;
+			char plainLetter = keys[s * EnglishLetters::SIZE + EnglishLetters::indexOf(cipherToCanonical[cipherIndex])];
+			plaintext[i] = EnglishLetters::isUpper(plaintext[i]) ? EnglishLetters::toUpper(plainLetter) : plainLetter;
 		}
-		//if the word hasn't already been used (stored in my list) and it has the most unknowns so far, save it
-		if (find(m_stackOfWordsUsed.begin(), m_stackOfWordsUsed.end(), currWord) == m_stackOfWordsUsed.end()
-			&& numUnknowns > mostUnknowns)				
-		{												
-			mostUnknowns = numUnknowns;					
-			indexOfWordWMostUnknowns = i;				
-		}												
+		solutions.push_back(plaintext);
 	}
+	return true;
+}
 
-	//save the word that I'm going to return to my list, then return it
-	m_stackOfWordsUsed.push_front(v[indexOfWordWMostUnknowns]);	
-	return v[indexOfWordWMostUnknowns];							
+//O(N * S + E), E = number of entries evicted to make room. O(1) if the entry can't be stored
+void ResultCache::insert(const std::string& ciphertext, unsigned long long generation, const std::vector<std::string>& solutions)
+{
+	//rough size of the entry: its strings plus the bookkeeping around them (the canonical message is as long as the
+	//ciphertext). it's known before anything is built, so a cache that's off or an entry too big for it costs nothing
+	std::size_t bytes = sizeof(Entry) + ciphertext.size() + solutions.size() * EnglishLetters::SIZE + 64;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (bytes > m_capacityInBytes || generation != m_generation)
+			return;
+	}
+
+	char cipherToCanonical[EnglishLetters::SIZE];
+	Entry entry;
+	entry.canonical = canonicalize(ciphertext, cipherToCanonical);
+	entry.bytes = bytes;
+
+	//each solution's key comes from reading off which plaintext letter sits where each relabeled letter does
+	entry.keys.assign(solutions.size() * EnglishLetters::SIZE, EnglishLetters::UNKNOWN);
+	for (std::size_t s = 0; s < solutions.size(); s++)
+	{
+		if (solutions[s].size() != ciphertext.size())
+			return;
+		char* key = &entry.keys[s * EnglishLetters::SIZE];
+		for (unsigned int i = 0; i < ciphertext.size(); i++)
+		{
+			int cipherIndex = EnglishLetters::indexOf(ciphertext[i]);
+			if (cipherIndex != EnglishLetters::NOT_A_LETTER)
+				key[EnglishLetters::indexOf(cipherToCanonical[cipherIndex])] = EnglishLetters::toLower(solutions[s][i]);
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	//an entry bigger than the whole cache (or a cache turned off) isn't stored, and neither is one another crack already
+	//stored or one found with a word list that has been replaced since. checked again, since either could have changed
+	if (entry.bytes > m_capacityInBytes || generation != m_generation || m_index.find(std::string_view(entry.canonical)) != nullptr)
+		return;
+	evictUntilUnder(m_capacityInBytes - entry.bytes);
+	m_bytesUsed += entry.bytes;
+	m_entries.push_front(std::move(entry));
+	m_index.associate(std::string_view(m_entries.front().canonical), m_entries.begin());
 }
 
-std::vector<std::string> DecrypterImpl::getFullyTranslatedWords(std::string ciphertext)
+//O(E)
+void ResultCache::startGeneration(unsigned long long generation)
 {
-	std::string translation = m_translator.getTranslation(ciphertext);
-	std::vector<std::string> allTranslatedWords = m_tokenizer.tokenize(translation);
-	std::vector<std::string> fullyTranslatedWords;
+	std::lock_guard<std::mutex> lock(m_mutex);
+	evictUntilUnder(0);
+	m_generation = generation;
+}
 
-	//for each word in allTranslatedWords
-	for (int i = 0; i < allTranslatedWords.size(); i++)		
+//O(N), N = length of every cached message
+int ResultCache::startGeneration(unsigned long long generation, const MyHash<std::string, bool>& changedPatterns, const Tokenizer& tokenizer)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_generation = generation;
+	int numErased = 0;
+	for (std::list<Entry>::iterator entry = m_entries.begin(); entry != m_entries.end(); )
 	{
-		std::string currWord = allTranslatedWords[i];
-		//if every letter in the word is known add it to the vector to return
-		if (isFullyTranslated(currWord))				
-			fullyTranslatedWords.push_back(currWord);	
+		//relabeling letters keeps every word's pattern, so the canonical message's words have the same ones
+		std::vector<std::string> words = tokenizer.tokenize(entry->canonical);
+		bool isAffected = false;
+		for (unsigned int w = 0; w < words.size() && !isAffected; w++)
+			isAffected = changedPatterns.find(EnglishLetters::getLetterPattern(words[w])) != nullptr;
+		if (!isAffected)
+		{
+			++entry;
+			continue;
+		}
+		m_index.erase(std::string_view(entry->canonical));
+		m_bytesUsed -= entry->bytes;
+		entry = m_entries.erase(entry);
+		numErased++;
 	}
-	//after every word has been looked at, return this vector
-	return fullyTranslatedWords;	
+	return numErased;
 }
 
-bool DecrypterImpl::isFullyTranslated(std::string translation)
+CrackCacheStats ResultCache::getStats() const
 {
-	//for each letter in the translation
-	for (int j = 0; j < translation.size(); j++)	
+	std::lock_guard<std::mutex> lock(m_mutex);
+	CrackCacheStats stats;
+	stats.hits = m_hits;
+	stats.misses = m_misses;
+	stats.evictions = m_evictions;
+	stats.numEntries = m_index.getNumItems();
+	stats.bytesUsed = m_bytesUsed;
+	stats.capacityInBytes = m_capacityInBytes;
+	return stats;
+}
+
+//O(N), N = length of message
+//relabels the message's letters a, b, c, ... (the alphabet's letters) in order of first appearance (ignoring case, keeping it in the
+//output), and sets cipherToCanonical[i] to the label of each cipher letter i that appears
+std::string ResultCache::canonicalize(const std::string& ciphertext, char cipherToCanonical[EnglishLetters::SIZE])
+{
+	for (int i = 0; i < EnglishLetters::SIZE; i++)
+		cipherToCanonical[i] = '\0';
+	int nextLabel = 0;
+	std::string canonical = ciphertext;
+	for (unsigned int i = 0; i < canonical.size(); i++)
 	{
-		//if a letter is unknown in the translation, return false
-		if (translation[j] == '?')			
-			return false;
+		int cipherIndex = EnglishLetters::indexOf(canonical[i]);
+		if (cipherIndex == EnglishLetters::NOT_A_LETTER)
+			continue;
+		char& label = cipherToCanonical[cipherIndex];
+		if (label == '\0')
+			label = EnglishLetters::letter(nextLabel++);
+		canonical[i] = EnglishLetters::isUpper(canonical[i]) ? EnglishLetters::toUpper(label) : label;
+	}
+	return canonical;
+}
+
+//O(E), E = number of entries evicted. the caller holds m_mutex
+void ResultCache::evictUntilUnder(std::size_t capacityInBytes)
+{
+	//drop least recently used entries (from the back) until the cache fits
+	while (!m_entries.empty() && m_bytesUsed > capacityInBytes)
+	{
+		m_index.erase(std::string_view(m_entries.back().canonical));
+		m_bytesUsed -= m_entries.back().bytes;
+		m_entries.pop_back();
+		m_evictions++;
 	}
-	//if all letters are known return true;
-	return true;	
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -201,7 +1373,87 @@ bool Decrypter::load(std::string filename)
 	return m_impl->load(filename);
 }
 
+void Decrypter::setLazyLoading(bool lazy)
+{
+	m_impl->setLazyLoading(lazy);
+}
+
+std::vector<WordListShardStats> Decrypter::getShardStats() const
+{
+	return m_impl->getShardStats();
+}
+
+void Decrypter::setTableStatsOutput(std::ostream* out)
+{
+	m_impl->setTableStatsOutput(out);
+}
+
+void Decrypter::printTableStats(std::ostream& out) const
+{
+	m_impl->printTableStats(out);
+}
+
+void Decrypter::setCacheCapacity(std::size_t bytes)
+{
+	m_impl->setCacheCapacity(bytes);
+}
+
+bool Decrypter::addWord(const std::string& word)
+{
+	return m_impl->addWord(word);
+}
+
+bool Decrypter::removeWord(const std::string& word)
+{
+	return m_impl->removeWord(word);
+}
+
+int Decrypter::applyDelta(const std::string& filename)
+{
+	return m_impl->applyDelta(filename);
+}
+
+CrackCacheStats Decrypter::getCacheStats() const
+{
+	return m_impl->getCacheStats();
+}
+
+void Decrypter::explainPlan(const std::string& ciphertext, std::ostream& out, const CrackOptions& options) const
+{
+	m_impl->explainPlan(ciphertext, options, out);
+}
+
+CrackCostEstimate Decrypter::estimateCost(const std::string& ciphertext) const
+{
+	return m_impl->estimateCost(ciphertext);
+}
+
+std::vector<CrackPortfolioStats> Decrypter::getPortfolioStats() const
+{
+	return m_impl->getPortfolioStats();
+}
+
+void Decrypter::setPortfolioLog(std::ostream* out)
+{
+	m_impl->setPortfolioLog(out);
+}
+
 std::vector<std::string> Decrypter::crack(const std::string& ciphertext)
 {
-	return m_impl->crack(ciphertext);
+	return m_impl->crack(ciphertext, CrackOptions()).solutions;
+}
+
+CrackResult Decrypter::crack(const std::string& ciphertext, const CrackOptions& options)
+{
+	return m_impl->crack(ciphertext, options);
+}
+
+CrackKeysResult Decrypter::crackKeys(const std::string& ciphertext, const CrackOptions& options)
+{
+	return m_impl->crackKeys(ciphertext, options);
+}
+
+JointCrackResult Decrypter::crackJoint(const std::vector<std::string>& ciphertexts, const CrackOptions& options)
+{
+	return m_impl->crackJoint(ciphertexts, options);
 }
@@ -0,0 +1,106 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+	: m_data(nullptr), m_size(0)
+#ifdef _WIN32
+	, m_fileHandle(INVALID_HANDLE_VALUE), m_mappingHandle(nullptr)
+#endif
+{}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+//O(1), the pages themselves are only read when they're touched
+bool MappedFile::open(const std::string& filename)
+{
+	//drop whatever was mapped before
+	close();
+
+#ifdef _WIN32
+	m_fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(m_fileHandle, &fileSize))
+	{
+		close();
+		return false;
+	}
+	m_size = static_cast<std::size_t>(fileSize.QuadPart);
+	//an empty file can't be mapped, but it's still a valid (empty) file
+	if (m_size == 0)
+		return true;
+	m_mappingHandle = CreateFileMappingA(m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (m_mappingHandle == nullptr)
+	{
+		close();
+		return false;
+	}
+	m_data = static_cast<const char*>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	if (m_data == nullptr)
+	{
+		close();
+		return false;
+	}
+#else
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat info;
+	if (fstat(fd, &info) != 0)
+	{
+		::close(fd);
+		return false;
+	}
+	m_size = static_cast<std::size_t>(info.st_size);
+	//an empty file can't be mapped, but it's still a valid (empty) file
+	if (m_size == 0)
+	{
+		::close(fd);
+		return true;
+	}
+	//MAP_SHARED so every process mapping this file uses the same physical pages
+	void* mapped = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+	//the mapping stays valid after the descriptor is closed
+	::close(fd);
+	if (mapped == MAP_FAILED)
+	{
+		m_size = 0;
+		return false;
+	}
+	m_data = static_cast<const char*>(mapped);
+#endif
+	return true;
+}
+
+//O(1)
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (m_data != nullptr)
+		UnmapViewOfFile(m_data);
+	if (m_mappingHandle != nullptr)
+		CloseHandle(m_mappingHandle);
+	if (m_fileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(m_fileHandle);
+	m_mappingHandle = nullptr;
+	m_fileHandle = INVALID_HANDLE_VALUE;
+#else
+	if (m_data != nullptr)
+		munmap(const_cast<char*>(m_data), m_size);
+#endif
+	m_data = nullptr;
+	m_size = 0;
+}
@@ -0,0 +1,32 @@
+#ifndef MAPPEDFILE_INCLUDED
+#define MAPPEDFILE_INCLUDED
+
+#include <cstddef>
+#include <string>
+
+//a read-only view of a whole file, mapped into memory instead of read into a buffer.
+//pages are only read from disk when they're touched, and every process mapping the same
+//file shares them
+class MappedFile
+{
+public:
+	MappedFile();
+	~MappedFile();
+	//returns false if the file can't be opened or mapped. an empty file maps successfully with size() 0
+	bool open(const std::string& filename);
+	void close();
+	const char* data() const { return m_data; }
+	std::size_t size() const { return m_size; }
+	// We prevent a MappedFile object from being copied or assigned.
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+private:
+	const char* m_data;
+	std::size_t m_size;
+#ifdef _WIN32
+	void* m_fileHandle;
+	void* m_mappingHandle;
+#endif
+};
+
+#endif // MAPPEDFILE_INCLUDED
@@ -1,31 +1,165 @@
 #ifndef MYHASH_G
 #define MYHASH_G
 
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
 //class used for simple linked list in each bucket
 template <class KeyType, class ValueType>
-class Node		
+class Node
 {
 public:
 	//toBeSetToMNext is the pointer from the correct bucket. If its empty its nullptr,
-	//if not the new Node is 'inserted' before the other Nodes	
-	Node(KeyType key, ValueType val, Node* toBeSetToMNext)
-		:m_key(key), m_val(val), m_next(toBeSetToMNext)	  
-	{}										
+	//if not the new Node is 'inserted' before the other Nodes
+	//the key is copied or moved in, and the value is built in place from valArgs
+	template <class K, class... V>
+	Node(K&& key, unsigned int hashValue, Node* toBeSetToMNext, V&&... valArgs)
+		:m_key(std::forward<K>(key)), m_val(std::forward<V>(valArgs)...), m_hash(hashValue), m_next(toBeSetToMNext)
+	{}
 	//standard node structure
-	KeyType m_key;		
-	ValueType m_val;	
-	Node* m_next;		
+	KeyType m_key;
+	ValueType m_val;
+	//the full hash of m_key, saved so rehashing never has to recompute it
+	unsigned int m_hash;
+	Node* m_next;
 };
 
 
-template <class KeyType, class ValueType>
+//hashers MyHash uses to turn a key into a 32-bit hash. bucket indexes are the low bits of the hash
+//(the bucket count is always a power of two), so a hasher must mix its result well
+
+//generic hasher: runs the free hash() function supplied for KeyType through a finalizer so its low bits are usable
+template <class KeyType>
+struct MyHashHasher
+{
+	unsigned int operator()(const KeyType& key) const
+	{
+		//prototype
+		unsigned int hash(const KeyType& k);
+		unsigned int h = hash(key);
+		//murmur3's 32-bit finalizer
+		h ^= h >> 16;
+		h *= 0x85EBCA6Bu;
+		h ^= h >> 13;
+		h *= 0xC2B2AE35u;
+		h ^= h >> 16;
+		return h;
+	}
+};
+
+//chars index their bucket directly (their value masked to the bucket count), so two chars only share a
+//bucket if they're equal modulo the bucket count. that can still happen: with 64, '\'' (39) and 'g' (103) do
+template <>
+struct MyHashHasher<char>
+{
+	unsigned int operator()(char c) const { return static_cast<unsigned char>(c); }
+};
+
+template <>
+struct MyHashHasher<int>
+{
+	unsigned int operator()(int k) const
+	{
+		//the same finalizer as the generic hasher, applied straight to the int
+		unsigned int h = static_cast<unsigned int>(k);
+		h ^= h >> 16;
+		h *= 0x85EBCA6Bu;
+		h ^= h >> 13;
+		h *= 0xC2B2AE35u;
+		h ^= h >> 16;
+		return h;
+	}
+};
+
+//O(L), tuned for dictionary words (almost all under 20 bytes): eats 8 bytes per multiply, so a
+//typical word takes one to three rounds plus the tail and a final mix
+inline unsigned int myHashBytes(const char* s, std::size_t len)
+{
+	unsigned long long h = 0x9E3779B97F4A7C15ull ^ len;
+	while (len >= 8)
+	{
+		unsigned long long w;
+		std::memcpy(&w, s, 8);
+		h = (h ^ w) * 0xBF58476D1CE4E5B9ull;
+		h ^= h >> 31;
+		s += 8;
+		len -= 8;
+	}
+	if (len > 0)
+	{
+		unsigned long long w = 0;
+		std::memcpy(&w, s, len);
+		h = (h ^ w) * 0x94D049BB133111EBull;
+		h ^= h >> 29;
+	}
+	h *= 0xD6E8FEB86659FD93ull;
+	h ^= h >> 32;
+	return static_cast<unsigned int>(h);
+}
+
+template <>
+struct MyHashHasher<std::string>
+{
+	unsigned int operator()(const std::string& s) const { return myHashBytes(s.data(), s.size()); }
+};
+
+template <>
+struct MyHashHasher<std::string_view>
+{
+	unsigned int operator()(std::string_view s) const { return myHashBytes(s.data(), s.size()); }
+};
+
+
+//what MyHash::getStats() reports. the histograms and byte count describe the table as it is now; the
+//find and rehash numbers only count what happened while stats were enabled (all zero otherwise)
+struct MyHashStats
+{
+	int numItems = 0;
+	int numBuckets = 0;
+	//bucketOccupancy[k] = number of buckets holding k items (so bucketOccupancy[0] is the empty buckets)
+	std::vector<int> bucketOccupancy;
+	//chainLengths[k] = number of items sitting in a chain of length k, i.e. what a lookup of an item
+	//that's there has to walk past in the worst case
+	std::vector<int> chainLengths;
+	//a probe is one node looked at. a find that lands in an empty bucket makes 0 probes
+	long long numHits = 0;
+	long long numMisses = 0;
+	double averageHitProbes = 0;
+	double averageMissProbes = 0;
+	int maxHitProbes = 0;
+	int maxMissProbes = 0;
+	//resizes started, and the time spent moving nodes to the new arrays
+	int numRehashes = 0;
+	double rehashSeconds = 0;
+	//the bucket arrays, node storage and the table itself, not counting memory the keys and values own
+	std::size_t bytesHeld = 0;
+};
+
+template <class KeyType, class ValueType, class Hasher = MyHashHasher<KeyType>>
 class MyHash
 {
 public:
-	MyHash(double maxLoadFactor = 0.5);
+	//if incrementalResize is true, growing the table keeps the old bucket array around and
+	//moves a few buckets per associate() instead of rehashing every node at once
+	MyHash(double maxLoadFactor = 0.5, bool incrementalResize = false);
 	~MyHash();
 	void reset();
+	void reserve(int numItems);
 	void associate(const KeyType& key, const ValueType& value);
+	void associate(KeyType&& key, ValueType&& value);
+	//returns the key's value, first building it in place from valArgs if the key isn't in the table yet
+	template <class... V>
+	ValueType* emplace(const KeyType& key, V&&... valArgs);
+	//removes the key (and its value) from the table. returns false if it wasn't there
+	bool erase(const KeyType& key);
 	const ValueType* find(const KeyType& key) const;
 	ValueType* find(const KeyType& key)
 	{
@@ -33,174 +167,528 @@ public:
 	}
 	int getNumItems() const;
 	double getLoadFactor() const;
+	//true while an incremental resize still has buckets left in the old array
+	bool isResizing() const { return m_oldBucketsOfHeads != nullptr; }
+	//starts (and zeroes) or stops counting probes and rehashes. off by default, since it puts atomic
+	//counters on find(). counting is safe with concurrent finds, like find() itself
+	void setStatsEnabled(bool enabled);
+	//O(B + X), walks every bucket to build the histograms
+	MyHashStats getStats() const;
+	//calls f(key, value) for every item, in no particular order. f must not change the table
+	template <class F>
+	void forEach(F f) const;
 private:
+	//number of old buckets moved to the new array by each associate() during an incremental resize
+	static const int BUCKETS_MIGRATED_PER_OP = 4;
+	//starting bucket count, and the count reset() goes back to. must be a power of two
+	//(64 holds a whole alphabet under the default load factor, and letter tables are created constantly)
+	static const int INITIAL_NUM_BUCKETS = 64;
+
+	//Nodes are carved out of blocks instead of allocated one at a time. each new block holds
+	//twice as many Nodes as the last (up to MAX_NODES_PER_BLOCK)
+	static const int MIN_NODES_PER_BLOCK = 16;
+	static const int MAX_NODES_PER_BLOCK = 4096;
+
 	int m_numBuckets;
 	int m_numItems;
 	double m_maxLoadFactor;
-	
+	bool m_incrementalResize;
+
 	//points to array which points to Nodes
-	Node<KeyType, ValueType>** m_bucketsOfHeads;	
+	Node<KeyType, ValueType>** m_bucketsOfHeads;
+
+	//during an incremental resize, the array being emptied into m_bucketsOfHeads. nullptr otherwise
+	//every old bucket below m_nextBucketToMigrate has already been moved
+	Node<KeyType, ValueType>** m_oldBucketsOfHeads;
+	int m_oldNumBuckets;
+	int m_nextBucketToMigrate;
+
+	//every block of Node storage, and how many Nodes of the newest block are still unused
+	std::vector<Node<KeyType, ValueType>*> m_nodeBlocks;
+	int m_nodeBlockSize;
+	int m_unusedNodesInBlock;
+	//storage of erased Nodes, reused before carving more out of a block. each one holds a pointer to the next
+	void* m_freeNodes;
 
-	unsigned int getBucketNumber(const KeyType& key) const
+	//nullptr unless stats are enabled. find() is const and may run on several threads, so these are atomic
+	struct Counters
 	{
-		//prototype
-		unsigned int hash(const KeyType& k);		
-		unsigned int h = hash(key) % m_numBuckets;
-		return h;
+		std::atomic<long long> numHits{ 0 };
+		std::atomic<long long> numMisses{ 0 };
+		std::atomic<long long> hitProbes{ 0 };
+		std::atomic<long long> missProbes{ 0 };
+		std::atomic<int> maxHitProbes{ 0 };
+		std::atomic<int> maxMissProbes{ 0 };
+		int numRehashes = 0;
+		long long rehashNanoseconds = 0;
+	};
+	std::unique_ptr<Counters> m_counters;
+
+	unsigned int getHash(const KeyType& key) const { return Hasher()(key); }
+
+	//bucket counts are powers of two, so the bucket is just the low bits of the hash (no division)
+	static int getBucketNumber(unsigned int h, int numBuckets) { return static_cast<int>(h & (numBuckets - 1)); }
+
+	//returns the head pointer of the bucket that a key with hash h currently lives in (old or new array)
+	Node<KeyType, ValueType>* const& getBucketHead(unsigned int h) const
+	{
+		if (m_oldBucketsOfHeads != nullptr && getBucketNumber(h, m_oldNumBuckets) >= m_nextBucketToMigrate)
+			return m_oldBucketsOfHeads[getBucketNumber(h, m_oldNumBuckets)];
+		return m_bucketsOfHeads[getBucketNumber(h, m_numBuckets)];
 	}
+
+	//calloc instead of new[] + a loop: big arrays come back as untouched zero pages, so a resize
+	//doesn't pay for clearing the whole array up front
+	static Node<KeyType, ValueType>** newEmptyBuckets(int numBuckets)
+	{
+		return static_cast<Node<KeyType, ValueType>**>(std::calloc(numBuckets, sizeof(Node<KeyType, ValueType>*)));
+	}
+
+	template <class K, class... V>
+	ValueType* insertNew(unsigned int h, K&& key, V&&... valArgs);
+	Node<KeyType, ValueType>* findNode(const KeyType& key, unsigned int h) const;
+	Node<KeyType, ValueType>* findNodeCounted(const KeyType& key, unsigned int h) const;
+	void startResize(int newNumBuckets);
+	void migrateBuckets(int maxBucketsToMove);
+	void destroyAllNodes();
+	static void destroyNodes(Node<KeyType, ValueType>** buckets, int numBuckets);
 };
 
 //O(B)
-template <class KeyType, class ValueType>
-MyHash<KeyType, ValueType>::MyHash(double maxLoadFactor) 
-	: m_numBuckets(100), m_numItems(0), m_maxLoadFactor(maxLoadFactor)
+template <class KeyType, class ValueType, class Hasher>
+MyHash<KeyType, ValueType, Hasher>::MyHash(double maxLoadFactor, bool incrementalResize)
+	: m_numBuckets(INITIAL_NUM_BUCKETS), m_numItems(0), m_maxLoadFactor(maxLoadFactor), m_incrementalResize(incrementalResize),
+	  m_oldBucketsOfHeads(nullptr), m_oldNumBuckets(0), m_nextBucketToMigrate(0),
+	  m_nodeBlockSize(0), m_unusedNodesInBlock(0), m_freeNodes(nullptr)
 {
 	// check and fix potential bad entries
-	if (m_maxLoadFactor <= 0)		
-		m_maxLoadFactor = 0.5;		
-	if (m_maxLoadFactor > 2)		
-		m_maxLoadFactor = 2.0;		
-	
-	//allocate a new array of length 100
-	m_bucketsOfHeads = new Node<KeyType, ValueType>*[100];	
-	
-	// set each bucket to hold a nullptr bc its empty
-	for (int i = 0; i < m_numBuckets; i++)	
-		m_bucketsOfHeads[i] = nullptr;		
+	if (m_maxLoadFactor <= 0)
+		m_maxLoadFactor = 0.5;
+	if (m_maxLoadFactor > 2)
+		m_maxLoadFactor = 2.0;
+
+	//allocate a new array of the starting length, each bucket holds a nullptr bc its empty
+	m_bucketsOfHeads = newEmptyBuckets(INITIAL_NUM_BUCKETS);
 }
 
 //O(B)
-template <class KeyType, class ValueType>
-MyHash<KeyType, ValueType>::~MyHash()
+template <class KeyType, class ValueType, class Hasher>
+MyHash<KeyType, ValueType, Hasher>::~MyHash()
 {
-	//go through each bucket
-	for (int i = 0; i < m_numBuckets; i++)	
-	{
-		// go through the list and delete all Nodes
-		Node<KeyType, ValueType>* n = m_bucketsOfHeads[i];	
-		while (n != nullptr)								
-		{													
-			Node<KeyType, ValueType>* killer = n;			
-			n = n->m_next;									
-			delete killer;									
-		}													
-	}
-	//delete array
-	delete[] m_bucketsOfHeads;
+	//delete all Nodes, then the arrays themselves
+	destroyAllNodes();
+	std::free(m_bucketsOfHeads);
+	if (m_oldBucketsOfHeads != nullptr)
+		std::free(m_oldBucketsOfHeads);
 }
 
 //O(B)
-template <class KeyType, class ValueType>
-void MyHash<KeyType, ValueType>::reset()
+template <class KeyType, class ValueType, class Hasher>
+void MyHash<KeyType, ValueType, Hasher>::reset()
 {
 	//same as ~MyHash()
-	for (int i = 0; i < m_numBuckets; i++)					
-	{														
-		Node<KeyType, ValueType>* n = m_bucketsOfHeads[i];	
-		while (n != nullptr)								
-		{													
-			Node<KeyType, ValueType>* killer = n;			
-			n = n->m_next;									
-			delete killer;									
-		}													
-	}														
-
-	//if the table grew beyond 100 buckets, create a new dynamically allocated array of 100 and delete old one
-	if (m_numBuckets != 100)																
-	{																						
-		Node<KeyType, ValueType>** toBeSetToBuckets = new Node<KeyType, ValueType>*[100];	
-		delete[] m_bucketsOfHeads;															
-		m_bucketsOfHeads = toBeSetToBuckets;												
-		m_numBuckets = 100;																	
-	}																						
-
-	//set each bucket to be empty
-	for (int i = 0; i < m_numBuckets; i++)				
-	{													
-		m_bucketsOfHeads[i] = nullptr;					
-	}													
+	destroyAllNodes();
+	if (m_oldBucketsOfHeads != nullptr)
+	{
+		std::free(m_oldBucketsOfHeads);
+		m_oldBucketsOfHeads = nullptr;
+		m_oldNumBuckets = 0;
+		m_nextBucketToMigrate = 0;
+	}
+
+	//if the table grew beyond the starting size, create a new empty array of that size and delete old one
+	//(destroyAllNodes already set each bucket of the current array to be empty)
+	if (m_numBuckets != INITIAL_NUM_BUCKETS)
+	{
+		std::free(m_bucketsOfHeads);
+		m_bucketsOfHeads = newEmptyBuckets(INITIAL_NUM_BUCKETS);
+		m_numBuckets = INITIAL_NUM_BUCKETS;
+	}
 
 	//reset item number member
-	m_numItems = 0;		
+	m_numItems = 0;
+}
+
+//O(B + X), only does work if the table is too small to hold numItems without passing the max load factor
+template <class KeyType, class ValueType, class Hasher>
+void MyHash<KeyType, ValueType, Hasher>::reserve(int numItems)
+{
+	//double the bucket count until numItems would fit
+	int newNumBuckets = m_numBuckets;
+	while (static_cast<double>(numItems) / static_cast<double>(newNumBuckets) > m_maxLoadFactor)
+		newNumBuckets *= 2;
+	if (newNumBuckets == m_numBuckets)
+		return;
+
+	//a second resize can't start until the first is done, and the caller asked for the space up front,
+	//so move everything now instead of spreading it out
+	if (m_oldBucketsOfHeads != nullptr)
+		migrateBuckets(m_oldNumBuckets);
+	startResize(newNumBuckets);
+	migrateBuckets(m_oldNumBuckets);
 }
 
 //O(1) / O(X) / O(B) depending on whether it needs new dynamic array
-template <class KeyType, class ValueType>
-void MyHash<KeyType, ValueType>::associate(const KeyType& key, const ValueType& val)
+template <class KeyType, class ValueType, class Hasher>
+void MyHash<KeyType, ValueType, Hasher>::associate(const KeyType& key, const ValueType& val)
+{
+	//pay off part of any resize in progress before touching the table
+	if (m_oldBucketsOfHeads != nullptr)
+		migrateBuckets(BUCKETS_MIGRATED_PER_OP);
+
+	//if the key already exists, change its val and return. else, add a new Node
+	unsigned int h = getHash(key);
+	Node<KeyType, ValueType>* n = findNode(key, h);
+	if (n != nullptr)
+		n->m_val = val;
+	else
+		insertNew(h, key, val);
+}
+
+//same as above, but moves the key and value into the table instead of copying them
+template <class KeyType, class ValueType, class Hasher>
+void MyHash<KeyType, ValueType, Hasher>::associate(KeyType&& key, ValueType&& val)
+{
+	if (m_oldBucketsOfHeads != nullptr)
+		migrateBuckets(BUCKETS_MIGRATED_PER_OP);
+
+	unsigned int h = getHash(key);
+	Node<KeyType, ValueType>* n = findNode(key, h);
+	if (n != nullptr)
+		n->m_val = std::move(val);
+	else
+		insertNew(h, std::move(key), std::move(val));
+}
+
+//O(1) / O(X) / O(B), like associate(). an existing value is left alone
+template <class KeyType, class ValueType, class Hasher>
+template <class... V>
+ValueType* MyHash<KeyType, ValueType, Hasher>::emplace(const KeyType& key, V&&... valArgs)
+{
+	if (m_oldBucketsOfHeads != nullptr)
+		migrateBuckets(BUCKETS_MIGRATED_PER_OP);
+
+	unsigned int h = getHash(key);
+	Node<KeyType, ValueType>* n = findNode(key, h);
+	if (n != nullptr)
+		return &(n->m_val);
+	return insertNew(h, key, std::forward<V>(valArgs)...);
+}
+
+//O(1)/O(X)
+template <class KeyType, class ValueType, class Hasher>
+bool MyHash<KeyType, ValueType, Hasher>::erase(const KeyType& key)
 {
-	//if the key already exists, change its val and return
-	if (find(key) != nullptr)	
+	//pay off part of any resize in progress before touching the table
+	if (m_oldBucketsOfHeads != nullptr)
+		migrateBuckets(BUCKETS_MIGRATED_PER_OP);
+
+	//walk the key's list keeping a pointer to the link that points at the current node
+	unsigned int h = getHash(key);
+	Node<KeyType, ValueType>** link = &const_cast<Node<KeyType, ValueType>*&>(getBucketHead(h));
+	while (*link != nullptr)
 	{
-		*find(key) = val;
-		return;
+		Node<KeyType, ValueType>* n = *link;
+		if (n->m_hash == h && n->m_key == key)
+		{
+			//unlink the node, destroy it, and keep its storage for the next insert
+			*link = n->m_next;
+			n->~Node();
+			*reinterpret_cast<void**>(n) = m_freeNodes;
+			m_freeNodes = n;
+			m_numItems--;
+			return true;
+		}
+		link = &(n->m_next);
 	}
-	//else, create a new Node at the correct bucket, with correct m_next, and increment numItems
-	else						
+	return false;
+}
+
+//O(1)/O(X)
+template <class KeyType, class ValueType, class Hasher>
+const ValueType* MyHash<KeyType, ValueType, Hasher>::find(const KeyType& key) const
+{
+	//if you find the key, return its reference. if not, return nullptr
+	Node<KeyType, ValueType>* n = (m_counters == nullptr) ? findNode(key, getHash(key)) : findNodeCounted(key, getHash(key));
+	if (n == nullptr)
+		return nullptr;
+	return &(n->m_val);
+}
+
+//O(1)/O(X)
+template <class KeyType, class ValueType, class Hasher>
+Node<KeyType, ValueType>* MyHash<KeyType, ValueType, Hasher>::findNode(const KeyType& key, unsigned int h) const
+{
+	//find the linked list the key would belong in
+	Node<KeyType, ValueType>* n = getBucketHead(h);
+	//go through each node in the list
+	while (n != nullptr)
+	{
+		//if you find the key, return its Node (comparing the saved hash first is cheaper than the key)
+		if (n->m_hash == h && n->m_key == key)
+			return n;
+		//if you dont move to next node
+		n = n->m_next;
+	}
+	//if you reach the end without finding it, return nullptr
+	return nullptr;
+}
+
+//O(1)/O(X). findNode(), also counting the probes for getStats()
+template <class KeyType, class ValueType, class Hasher>
+Node<KeyType, ValueType>* MyHash<KeyType, ValueType, Hasher>::findNodeCounted(const KeyType& key, unsigned int h) const
+{
+	int probes = 0;
+	Node<KeyType, ValueType>* n = getBucketHead(h);
+	while (n != nullptr)
 	{
-		m_bucketsOfHeads[getBucketNumber(key)] = new Node<KeyType, ValueType>(key, val, m_bucketsOfHeads[getBucketNumber(key)]);
-		m_numItems++;
+		probes++;
+		if (n->m_hash == h && n->m_key == key)
+			break;
+		n = n->m_next;
 	}
 
+	//add to the hit or miss totals, and raise the max if this one beat it
+	std::atomic<int>& maxProbes = (n != nullptr) ? m_counters->maxHitProbes : m_counters->maxMissProbes;
+	(n != nullptr ? m_counters->numHits : m_counters->numMisses).fetch_add(1, std::memory_order_relaxed);
+	(n != nullptr ? m_counters->hitProbes : m_counters->missProbes).fetch_add(probes, std::memory_order_relaxed);
+	int oldMax = maxProbes.load(std::memory_order_relaxed);
+	while (probes > oldMax && !maxProbes.compare_exchange_weak(oldMax, probes, std::memory_order_relaxed))
+		;
+	return n;
+}
+
+//O(1) amortized / O(B) if it needs a new dynamic array. the caller has checked the key isn't already there
+template <class KeyType, class ValueType, class Hasher>
+template <class K, class... V>
+ValueType* MyHash<KeyType, ValueType, Hasher>::insertNew(unsigned int h, K&& key, V&&... valArgs)
+{
+	//reuse an erased Node's storage if there is one
+	Node<KeyType, ValueType>* storage;
+	if (m_freeNodes != nullptr)
+	{
+		storage = static_cast<Node<KeyType, ValueType>*>(m_freeNodes);
+		m_freeNodes = *static_cast<void**>(m_freeNodes);
+	}
+	//if the newest block of Node storage is used up, allocate a bigger one
+	else
+	{
+		if (m_unusedNodesInBlock == 0)
+		{
+			m_nodeBlockSize = (m_nodeBlockSize == 0) ? MIN_NODES_PER_BLOCK : m_nodeBlockSize * 2;
+			if (m_nodeBlockSize > MAX_NODES_PER_BLOCK)
+				m_nodeBlockSize = MAX_NODES_PER_BLOCK;
+			m_nodeBlocks.push_back(static_cast<Node<KeyType, ValueType>*>(::operator new(m_nodeBlockSize * sizeof(Node<KeyType, ValueType>))));
+			m_unusedNodesInBlock = m_nodeBlockSize;
+		}
+		storage = m_nodeBlocks.back() + (m_nodeBlockSize - m_unusedNodesInBlock);
+		m_unusedNodesInBlock--;
+	}
+
+	//create a new Node at the front of the correct bucket, and increment numItems
+	//(if the key's old bucket hasn't moved yet, that's the old bucket so the chain stays together)
+	Node<KeyType, ValueType>*& head = const_cast<Node<KeyType, ValueType>*&>(getBucketHead(h));
+	head = new (storage) Node<KeyType, ValueType>(std::forward<K>(key), h, head, std::forward<V>(valArgs)...);
+	m_numItems++;
+	ValueType* toReturn = &(head->m_val);
+
 	//if we need to resize dynamic array
-	if (getLoadFactor() > m_maxLoadFactor)	
-	{
-		//save the old number of buckets for for-loop, update member to double length
-		int oldNumBuckets = m_numBuckets;	
-		m_numBuckets *= 2;					
-
-		//dynamically allocate a new and empty array of double the size
-		Node<KeyType, ValueType>** toBeSetToBuckets = new Node<KeyType, ValueType>*[m_numBuckets];	
-		for (int i = 0; i < m_numBuckets; i++)														
-			toBeSetToBuckets[i] = nullptr;															
-
-		//for each bucket in current m_bucketsOfHeads...
-		for (int i = 0; i < oldNumBuckets; i++)					
-		{											
-			//and for each Node in each bucket
-			Node<KeyType, ValueType>* n = m_bucketsOfHeads[i];	
-			while (n != nullptr)								
+	if (getLoadFactor() > m_maxLoadFactor)
+	{
+		//a second resize can't start until the first is done
+		if (m_oldBucketsOfHeads != nullptr)
+			migrateBuckets(m_oldNumBuckets);
+		startResize(m_numBuckets * 2);
+
+		//without incremental resizing, move every node right away like before
+		if (!m_incrementalResize)
+			migrateBuckets(m_oldNumBuckets);
+	}
+	return toReturn;
+}
+
+template <class KeyType, class ValueType, class Hasher>
+int MyHash<KeyType, ValueType, Hasher>::getNumItems() const { return m_numItems; }
+
+template <class KeyType, class ValueType, class Hasher>
+double MyHash<KeyType, ValueType, Hasher>::getLoadFactor() const { return ((static_cast<double>(m_numItems)) / static_cast<double>(m_numBuckets)); }
+
+//O(1)
+template <class KeyType, class ValueType, class Hasher>
+void MyHash<KeyType, ValueType, Hasher>::setStatsEnabled(bool enabled)
+{
+	if (enabled)
+		m_counters.reset(new Counters);
+	else
+		m_counters.reset();
+}
+
+//O(B + X)
+template <class KeyType, class ValueType, class Hasher>
+MyHashStats MyHash<KeyType, ValueType, Hasher>::getStats() const
+{
+	MyHashStats stats;
+	stats.numItems = m_numItems;
+	stats.numBuckets = m_numBuckets;
+
+	//count the length of every chain, in both arrays if a resize is halfway done
+	auto countChains = [&stats](Node<KeyType, ValueType>* const* buckets, int begin, int end)
+	{
+		for (int i = begin; i < end; i++)
+		{
+			int length = 0;
+			for (const Node<KeyType, ValueType>* n = buckets[i]; n != nullptr; n = n->m_next)
+				length++;
+			if (static_cast<int>(stats.bucketOccupancy.size()) <= length)
 			{
-				//set this variable before changing anything	
-				Node<KeyType, ValueType>* nextNodeToCheck = n->m_next;
-				//set n's new m_next to its new bucket index's pointing value
-				n->m_next = toBeSetToBuckets[getBucketNumber(n->m_key)];	
-				//set the bucket at that index to point to the newly moved node
-				toBeSetToBuckets[getBucketNumber(n->m_key)] = n;		
-				//increment the traversing node pointer to the next one (it will become nullptr if its the last one)
-				n = nextNodeToCheck;										
+				stats.bucketOccupancy.resize(length + 1, 0);
+				stats.chainLengths.resize(length + 1, 0);
 			}
+			stats.bucketOccupancy[length]++;
+			stats.chainLengths[length] += length;
 		}
+	};
+	countChains(m_bucketsOfHeads, 0, m_numBuckets);
+	if (m_oldBucketsOfHeads != nullptr)
+		countChains(m_oldBucketsOfHeads, m_nextBucketToMigrate, m_oldNumBuckets);
+
+	if (m_counters != nullptr)
+	{
+		stats.numHits = m_counters->numHits;
+		stats.numMisses = m_counters->numMisses;
+		if (stats.numHits > 0)
+			stats.averageHitProbes = static_cast<double>(m_counters->hitProbes) / stats.numHits;
+		if (stats.numMisses > 0)
+			stats.averageMissProbes = static_cast<double>(m_counters->missProbes) / stats.numMisses;
+		stats.maxHitProbes = m_counters->maxHitProbes;
+		stats.maxMissProbes = m_counters->maxMissProbes;
+		stats.numRehashes = m_counters->numRehashes;
+		stats.rehashSeconds = m_counters->rehashNanoseconds / 1e9;
+	}
 
-		//delete the dynamically allocated array
-		delete[] m_bucketsOfHeads;				
-		//set the array pointer to point to newly made array
-		m_bucketsOfHeads = toBeSetToBuckets;	
+	//the blocks of Node storage grew from MIN_NODES_PER_BLOCK, doubling up to MAX_NODES_PER_BLOCK
+	std::size_t numNodeSlots = 0;
+	int blockSize = MIN_NODES_PER_BLOCK;
+	for (unsigned int i = 0; i < m_nodeBlocks.size(); i++)
+	{
+		numNodeSlots += blockSize;
+		if (blockSize < MAX_NODES_PER_BLOCK)
+			blockSize *= 2;
 	}
+	stats.bytesHeld = sizeof(*this)
+		+ (static_cast<std::size_t>(m_numBuckets) + m_oldNumBuckets) * sizeof(Node<KeyType, ValueType>*)
+		+ numNodeSlots * sizeof(Node<KeyType, ValueType>)
+		+ m_nodeBlocks.capacity() * sizeof(Node<KeyType, ValueType>*)
+		+ (m_counters != nullptr ? sizeof(Counters) : 0);
+	return stats;
 }
 
-//O(1)/O(X)
-template <class KeyType, class ValueType>
-const ValueType* MyHash<KeyType, ValueType>::find(const KeyType& key) const
-{	
-	//find the linked list the key would belong in
-	Node<KeyType, ValueType>* n = m_bucketsOfHeads[getBucketNumber(key)];	
-	//go through each node in the list
-	while (n != nullptr)						
-	{											
-		//if you find the key, return its reference
-		if (n->m_key == key)					
-			return &(n->m_val);		
-		//if you dont move to next node
-		n = n->m_next;							
-	}										
-	//if you reach the end without finding it, return nullptr
-	return nullptr;		
+//O(B + X)
+template <class KeyType, class ValueType, class Hasher>
+template <class F>
+void MyHash<KeyType, ValueType, Hasher>::forEach(F f) const
+{
+	//both arrays if a resize is halfway done, the old one only from the first bucket not moved yet
+	for (int i = 0; i < m_numBuckets; i++)
+		for (const Node<KeyType, ValueType>* n = m_bucketsOfHeads[i]; n != nullptr; n = n->m_next)
+			f(n->m_key, n->m_val);
+	if (m_oldBucketsOfHeads != nullptr)
+		for (int i = m_nextBucketToMigrate; i < m_oldNumBuckets; i++)
+			for (const Node<KeyType, ValueType>* n = m_oldBucketsOfHeads[i]; n != nullptr; n = n->m_next)
+				f(n->m_key, n->m_val);
 }
 
-template <class KeyType, class ValueType>
-int MyHash<KeyType, ValueType>::getNumItems() const { return m_numItems; }
+//O(B), B = newNumBuckets
+template <class KeyType, class ValueType, class Hasher>
+void MyHash<KeyType, ValueType, Hasher>::startResize(int newNumBuckets)
+{
+	if (m_counters != nullptr)
+		m_counters->numRehashes++;
 
-template <class KeyType, class ValueType>
-double MyHash<KeyType, ValueType>::getLoadFactor() const { return ((static_cast<double>(m_numItems)) / static_cast<double>(m_numBuckets)); }
+	//the current array becomes the old array, and nothing in it has been moved yet
+	m_oldBucketsOfHeads = m_bucketsOfHeads;
+	m_oldNumBuckets = m_numBuckets;
+	m_nextBucketToMigrate = 0;
+
+	//dynamically allocate a new and empty array of the new size
+	m_numBuckets = newNumBuckets;
+	m_bucketsOfHeads = newEmptyBuckets(m_numBuckets);
+}
+
+//O(K + X), K = maxBucketsToMove
+template <class KeyType, class ValueType, class Hasher>
+void MyHash<KeyType, ValueType, Hasher>::migrateBuckets(int maxBucketsToMove)
+{
+	//only read the clock if someone is counting
+	std::chrono::steady_clock::time_point start;
+	if (m_counters != nullptr)
+		start = std::chrono::steady_clock::now();
+
+	//for each of the next old buckets...
+	for (int moved = 0; moved < maxBucketsToMove && m_nextBucketToMigrate < m_oldNumBuckets; moved++)
+	{
+		//and for each Node in the bucket
+		Node<KeyType, ValueType>* n = m_oldBucketsOfHeads[m_nextBucketToMigrate];
+		while (n != nullptr)
+		{
+			//set this variable before changing anything
+			Node<KeyType, ValueType>* nextNodeToCheck = n->m_next;
+			//relink n at the front of its new bucket, using the saved hash instead of rehashing the key
+			Node<KeyType, ValueType>*& head = m_bucketsOfHeads[getBucketNumber(n->m_hash, m_numBuckets)];
+			n->m_next = head;
+			head = n;
+			n = nextNodeToCheck;
+		}
+		m_oldBucketsOfHeads[m_nextBucketToMigrate] = nullptr;
+		m_nextBucketToMigrate++;
+	}
+
+	//once every old bucket is empty, delete the old array
+	if (m_nextBucketToMigrate == m_oldNumBuckets)
+	{
+		std::free(m_oldBucketsOfHeads);
+		m_oldBucketsOfHeads = nullptr;
+		m_oldNumBuckets = 0;
+		m_nextBucketToMigrate = 0;
+	}
+
+	if (m_counters != nullptr)
+		m_counters->rehashNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+//O(B + X)
+template <class KeyType, class ValueType, class Hasher>
+void MyHash<KeyType, ValueType, Hasher>::destroyAllNodes()
+{
+	//run every Node's destructor in both arrays, then give back all the Node storage at once
+	destroyNodes(m_bucketsOfHeads, m_numBuckets);
+	if (m_oldBucketsOfHeads != nullptr)
+		destroyNodes(m_oldBucketsOfHeads, m_oldNumBuckets);
+	for (unsigned int i = 0; i < m_nodeBlocks.size(); i++)
+		::operator delete(m_nodeBlocks[i]);
+	m_nodeBlocks.clear();
+	m_nodeBlockSize = 0;
+	m_unusedNodesInBlock = 0;
+	m_freeNodes = nullptr;
+}
+
+//O(B + X)
+template <class KeyType, class ValueType, class Hasher>
+void MyHash<KeyType, ValueType, Hasher>::destroyNodes(Node<KeyType, ValueType>** buckets, int numBuckets)
+{
+	//go through each bucket
+	for (int i = 0; i < numBuckets; i++)
+	{
+		// go through the list and destroy all Nodes (their storage belongs to the blocks)
+		Node<KeyType, ValueType>* n = buckets[i];
+		while (n != nullptr)
+		{
+			Node<KeyType, ValueType>* killer = n;
+			n = n->m_next;
+			killer->~Node();
+		}
+		buckets[i] = nullptr;
+	}
+}
 
 #endif
\ No newline at end of file
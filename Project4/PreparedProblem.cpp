@@ -0,0 +1,86 @@
+#include "PreparedProblem.h"
+#include "MyHash.h"
+
+//O(W * L + C * L), W = number of words in the message, C = number of candidates found, L = word length
+PreparedProblem::PreparedProblem(const std::string& ciphertext, const std::vector<std::string>& cipherWords, const WordList& dictionary)
+	: m_ciphertext(ciphertext), m_messageMask(0), m_numUntranslatable(0)
+{
+	//index of each distinct word already added, so repeats (in any case) share one entry
+	MyHash<std::string, int> wordIndexes;
+	for (unsigned int w = 0; w < cipherWords.size(); w++)
+	{
+		Word word;
+		word.cipherMask = 0;
+		word.numUntranslatable = 0;
+		word.numOccurrences = 1;
+		//the translation the search starts from: every letter unknown, everything else as it is
+		std::string noTranslation(cipherWords[w]);
+		for (unsigned int i = 0; i < cipherWords[w].size(); i++)
+		{
+			char c = cipherWords[w][i];
+			int cipherIndex = EnglishLetters::indexOf(c);
+			word.text += EnglishLetters::toLower(c);
+			if (cipherIndex != EnglishLetters::NOT_A_LETTER)
+			{
+				if (!(word.cipherMask & (1u << cipherIndex)))
+					word.letters.push_back(static_cast<unsigned char>(cipherIndex));
+				word.cipherMask |= 1u << cipherIndex;
+				noTranslation[i] = EnglishLetters::UNKNOWN;
+			}
+			else if (c == EnglishLetters::UNKNOWN)
+				word.numUntranslatable++;
+		}
+		const int* existingIndex = wordIndexes.find(word.text);
+		if (existingIndex != nullptr)
+		{
+			m_words[*existingIndex].numOccurrences++;
+			m_wordOfToken.push_back(*existingIndex);
+			continue;
+		}
+		m_wordOfToken.push_back(static_cast<int>(m_words.size()));
+		wordIndexes.associate(word.text, static_cast<int>(m_words.size()));
+		m_messageMask |= word.cipherMask;
+		m_numUntranslatable += word.numUntranslatable;
+
+		//every dictionary word with the right pattern, boiled down to its letter pairs (each distinct
+		//cipher letter once, since the matching pattern means a repeat always pairs the same way)
+		std::vector<std::string> plaintexts = dictionary.findCandidates(word.text, noTranslation);
+		word.candidates.reserve(plaintexts.size());
+		for (unsigned int p = 0; p < plaintexts.size(); p++)
+		{
+			Candidate candidate;
+			candidate.cipherMask = 0;
+			candidate.plainMask = 0;
+			candidate.firstPair = static_cast<int>(word.pairs.size());
+			bool isGood = true;
+			for (unsigned int i = 0; i < word.text.size(); i++)
+			{
+				int cipherIndex = EnglishLetters::indexOf(word.text[i]);
+				if (cipherIndex == EnglishLetters::NOT_A_LETTER || (candidate.cipherMask & (1u << cipherIndex)))
+					continue;
+				//a dictionary word can have an apostrophe where the cipher word has a letter, which no key allows
+				int plainIndex = EnglishLetters::indexOf(plaintexts[p][i]);
+				if (plainIndex == EnglishLetters::NOT_A_LETTER)
+				{
+					isGood = false;
+					break;
+				}
+				LetterPair pair;
+				pair.cipher = static_cast<unsigned char>(cipherIndex);
+				pair.plain = static_cast<unsigned char>(plainIndex);
+				word.pairs.push_back(pair);
+				candidate.cipherMask |= 1u << cipherIndex;
+				candidate.plainMask |= 1u << plainIndex;
+			}
+			if (!isGood)
+			{
+				word.pairs.resize(candidate.firstPair);
+				continue;
+			}
+			candidate.numPairs = static_cast<int>(word.pairs.size()) - candidate.firstPair;
+			candidate.plaintext = std::move(plaintexts[p]);
+			word.candidates.push_back(std::move(candidate));
+		}
+		m_words.push_back(std::move(word));
+	}
+}
@@ -0,0 +1,256 @@
+#ifndef PREPAREDPROBLEM_INCLUDED
+#define PREPAREDPROBLEM_INCLUDED
+
+#include "provided.h"
+#include "Alphabet.h"
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+//everything crack() can work out about a message before it starts searching: the distinct words of the
+//message, and for each one every dictionary word with the same letter pattern, already boiled down to
+//the letter pairs it would add to the key. checking a candidate against the key during the search is
+//then a couple of mask ANDs, plus one compare per touched letter if those come up nonzero
+class PreparedProblem
+{
+public:
+	//letters are identified by index (0 to SIZE - 1), and sets of letters are bitmasks of indexes
+	static_assert(EnglishLetters::SIZE <= 32, "letter sets have to fit in an unsigned int");
+
+	struct LetterPair
+	{
+		unsigned char cipher;
+		unsigned char plain;
+	};
+
+	//one dictionary word a cipher word could be
+	struct Candidate
+	{
+		std::string plaintext;
+		//the cipher letters of the word, and the plain letters they would map to
+		unsigned int cipherMask;
+		unsigned int plainMask;
+		//this candidate's pairs are pairs[firstPair, firstPair + numPairs) of its Word, one per distinct letter
+		int firstPair;
+		int numPairs;
+	};
+
+	//one distinct (lowercased) word of the message
+	struct Word
+	{
+		std::string text;
+		unsigned int cipherMask;
+		//the word's distinct cipher letters in order of first appearance. every candidate's pairs are in
+		//this same order, so the plain letter a candidate gives letters[i] is its pairs[firstPair + i]
+		std::vector<unsigned char> letters;
+		//characters in the word that never get a translation (a literal '?'), so it can never be fully translated
+		int numUntranslatable;
+		//how many times the word appears in the message
+		int numOccurrences;
+		std::vector<Candidate> candidates;
+		std::vector<LetterPair> pairs;
+	};
+
+	//cipherWords are the message's words as the tokenizer split them
+	PreparedProblem(const std::string& ciphertext, const std::vector<std::string>& cipherWords, const WordList& dictionary);
+	const std::string& getCiphertext() const { return m_ciphertext; }
+	int getNumWords() const { return static_cast<int>(m_words.size()); }
+	const Word& getWord(int i) const { return m_words[i]; }
+	//the words as the tokenizer gave them, repeats included, and which distinct word each one is
+	int getNumTokens() const { return static_cast<int>(m_wordOfToken.size()); }
+	int getWordOfToken(int t) const { return m_wordOfToken[t]; }
+	//every cipher letter in the message
+	unsigned int getMessageMask() const { return m_messageMask; }
+	//true if the message is translated once every letter in it is mapped (no word has a literal '?')
+	bool canBeFullyTranslated() const { return m_numUntranslatable == 0; }
+private:
+	std::string m_ciphertext;
+	//in order of first appearance in the message
+	std::vector<Word> m_words;
+	std::vector<int> m_wordOfToken;
+	unsigned int m_messageMask;
+	int m_numUntranslatable;
+};
+
+//the key the search builds up: which cipher letters map to which plain letters so far, along with
+//the sets of letters already mapped on each side
+class LetterKey
+{
+public:
+	typedef PreparedProblem::Word Word;
+	typedef PreparedProblem::Candidate Candidate;
+	typedef PreparedProblem::LetterPair LetterPair;
+
+	LetterKey() : m_mappedCipher(0), m_mappedPlain(0) {}
+	unsigned int getMappedCipher() const { return m_mappedCipher; }
+	//the plain letter a mapped cipher letter goes to
+	int getPlain(int cipherIndex) const { return m_cipherToPlain[cipherIndex]; }
+
+	//O(1) if the candidate shares no letters with the key, O(P) otherwise, P = distinct letters in the word.
+	//true if mapping word to the candidate doesn't contradict the key in either direction
+	bool isCompatible(const Word& word, const Candidate& candidate) const
+	{
+		unsigned int knownCipher = candidate.cipherMask & m_mappedCipher;
+		unsigned int knownPlain = candidate.plainMask & m_mappedPlain;
+		//nothing in common with the key, so nothing to contradict
+		if ((knownCipher | knownPlain) == 0)
+			return true;
+		//each known cipher letter has to already map to the candidate's plain letter, and each new
+		//cipher letter has to go to a plain letter nothing maps to yet
+		const LetterPair* pairs = &word.pairs[candidate.firstPair];
+		for (int i = 0; i < candidate.numPairs; i++)
+		{
+			if (knownCipher & (1u << pairs[i].cipher))
+			{
+				if (m_cipherToPlain[pairs[i].cipher] != pairs[i].plain)
+					return false;
+			}
+			else if (knownPlain & (1u << pairs[i].plain))
+				return false;
+		}
+		return true;
+	}
+
+	//O(P). adds the candidate's pairs (which have to be compatible) and returns the cipher letters that are new
+	unsigned int apply(const Word& word, const Candidate& candidate)
+	{
+		unsigned int added = candidate.cipherMask & ~m_mappedCipher;
+		const LetterPair* pairs = &word.pairs[candidate.firstPair];
+		for (int i = 0; i < candidate.numPairs; i++)
+		{
+			if (added & (1u << pairs[i].cipher))
+			{
+				m_cipherToPlain[pairs[i].cipher] = pairs[i].plain;
+				m_mappedPlain |= 1u << pairs[i].plain;
+			}
+		}
+		m_mappedCipher |= added;
+		return added;
+	}
+
+	//O(1). maps one cipher letter, unless either letter is already part of a different pair.
+	//returns false (changing nothing) if it can't
+	bool fix(int cipherIndex, int plainIndex)
+	{
+		if (m_mappedCipher & (1u << cipherIndex))
+			return m_cipherToPlain[cipherIndex] == plainIndex;
+		if (m_mappedPlain & (1u << plainIndex))
+			return false;
+		m_cipherToPlain[cipherIndex] = static_cast<unsigned char>(plainIndex);
+		m_mappedCipher |= 1u << cipherIndex;
+		m_mappedPlain |= 1u << plainIndex;
+		return true;
+	}
+
+	//O(P). takes back the letters apply() returned as added
+	void undo(const Word& word, const Candidate& candidate, unsigned int added)
+	{
+		const LetterPair* pairs = &word.pairs[candidate.firstPair];
+		for (int i = 0; i < candidate.numPairs; i++)
+			if (added & (1u << pairs[i].cipher))
+				m_mappedPlain &= ~(1u << pairs[i].plain);
+		m_mappedCipher &= ~added;
+	}
+
+	bool isFullyTranslated(const Word& word) const
+	{
+		return (word.cipherMask & ~m_mappedCipher) == 0 && word.numUntranslatable == 0;
+	}
+
+	//O(N). letters that aren't mapped yet become '?', and everything else keeps its case
+	std::string translate(const std::string& ciphertext) const
+	{
+		std::string translation(ciphertext);
+		for (unsigned int i = 0; i < translation.size(); i++)
+		{
+			int cipherIndex = EnglishLetters::indexOf(translation[i]);
+			if (cipherIndex == EnglishLetters::NOT_A_LETTER)
+				continue;
+			char plainLetter = (m_mappedCipher & (1u << cipherIndex)) ? EnglishLetters::letter(m_cipherToPlain[cipherIndex]) : EnglishLetters::UNKNOWN;
+			translation[i] = EnglishLetters::isUpper(translation[i]) ? EnglishLetters::toUpper(plainLetter) : plainLetter;
+		}
+		return translation;
+	}
+
+	//O(SIZE). the plain letter of each cipher letter in order, '?' for the ones that aren't mapped
+	std::string getKey() const
+	{
+		std::string key(EnglishLetters::SIZE, EnglishLetters::UNKNOWN);
+		for (int i = 0; i < EnglishLetters::SIZE; i++)
+			if (m_mappedCipher & (1u << i))
+				key[i] = EnglishLetters::letter(m_cipherToPlain[i]);
+		return key;
+	}
+private:
+	//only the entries of mapped cipher letters mean anything
+	unsigned char m_cipherToPlain[EnglishLetters::SIZE];
+	unsigned int m_mappedCipher;
+	unsigned int m_mappedPlain;
+};
+
+//the keys a search finds. a message can have tens of millions of solutions, so the keys are kept in blocks
+//instead of one array: growing never copies them, and popping them off the back frees each block as soon
+//as it's empty. a block's size doubles from MIN_KEYS_PER_BLOCK up to MAX_KEYS_PER_BLOCK, which is big enough
+//that the allocator maps it on its own and gives its pages straight back when it's freed
+class KeyList
+{
+public:
+	KeyList() : m_size(0) {}
+	std::size_t size() const { return m_size; }
+	bool empty() const { return m_size == 0; }
+	LetterKey& back() { return m_blocks.back().back(); }
+
+	//O(1), or O(K) to start a new block of K keys
+	void push_back(const LetterKey& key)
+	{
+		if (m_blocks.empty() || m_blocks.back().size() == m_blocks.back().capacity())
+		{
+			std::size_t blockSize = m_blocks.empty() ? MIN_KEYS_PER_BLOCK : std::min(2 * m_blocks.back().capacity(), MAX_KEYS_PER_BLOCK);
+			m_blocks.push_back(std::vector<LetterKey>());
+			m_blocks.back().reserve(blockSize);
+		}
+		m_blocks.back().push_back(key);
+		m_size++;
+	}
+
+	//O(1)
+	void pop_back()
+	{
+		m_blocks.back().pop_back();
+		if (m_blocks.back().empty())
+			m_blocks.pop_back();
+		m_size--;
+	}
+
+	//O(S - newSize), S = size(). only ever shrinks the list
+	void resize(std::size_t newSize)
+	{
+		while (m_size > newSize)
+			pop_back();
+	}
+
+	void clear()
+	{
+		m_blocks.clear();
+		m_size = 0;
+	}
+
+	//O(B), B = number of blocks (a few dozen even for millions of keys)
+	const LetterKey& operator[](std::size_t i) const
+	{
+		unsigned int b = 0;
+		for (; i >= m_blocks[b].size(); b++)
+			i -= m_blocks[b].size();
+		return m_blocks[b][i];
+	}
+private:
+	static const std::size_t MIN_KEYS_PER_BLOCK = 16;
+	static const std::size_t MAX_KEYS_PER_BLOCK = 1 << 20;
+
+	//every block but the last is full
+	std::vector<std::vector<LetterKey>> m_blocks;
+	std::size_t m_size;
+};
+
+#endif // PREPAREDPROBLEM_INCLUDED
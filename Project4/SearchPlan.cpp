@@ -0,0 +1,169 @@
+#include "SearchPlan.h"
+#include <algorithm>
+#include <ostream>
+
+//the letters in mask, in alphabetical order
+static std::string getLetters(unsigned int mask)
+{
+	std::string letters;
+	for (int i = 0; i < EnglishLetters::SIZE; i++)
+		if (mask & (1u << i))
+			letters += EnglishLetters::letter(i);
+	return letters;
+}
+
+SearchPlan::SearchPlan(const PreparedProblem& problem, CrackWordOrder order, unsigned int knownLetters, const std::vector<bool>& isWordCrib)
+	: m_knownLetters(knownLetters)
+{
+	//how many times each of a word's letters appears in it, in the order of Word::letters
+	std::vector<std::vector<int>> letterCounts(problem.getNumWords());
+	for (int w = 0; w < problem.getNumWords(); w++)
+	{
+		const PreparedProblem::Word& word = problem.getWord(w);
+		letterCounts[w].assign(word.letters.size(), 0);
+		for (unsigned int j = 0; j < word.text.size(); j++)
+		{
+			int cipherIndex = EnglishLetters::indexOf(word.text[j]);
+			for (unsigned int i = 0; i < word.letters.size() && cipherIndex != EnglishLetters::NOT_A_LETTER; i++)
+				if (word.letters[i] == cipherIndex)
+					letterCounts[w][i]++;
+		}
+	}
+
+	//pick each step's word the way the search would (ties go to the word that comes first), then
+	//see which words its letters finish
+	std::vector<bool> isWordUsed(problem.getNumWords(), false);
+	unsigned int known = knownLetters;
+	for (;;)
+	{
+		int best = -1;
+		int bestScore = 0;
+		for (int w = 0; w < problem.getNumWords(); w++)
+		{
+			const PreparedProblem::Word& word = problem.getWord(w);
+			if (isWordUsed[w])
+				continue;
+			//most unknown letters counts each unknown letter every time it appears (and each literal '?').
+			//longest word only needs there to be one
+			int score = word.numUntranslatable;
+			for (unsigned int i = 0; i < word.letters.size(); i++)
+				if (!(known & (1u << word.letters[i])))
+					score += letterCounts[w][i];
+			if (order == CrackWordOrder::LongestWord && score > 0)
+				score = static_cast<int>(word.text.size());
+			if (score > bestScore)
+			{
+				bestScore = score;
+				best = w;
+			}
+		}
+		if (best < 0)
+			break;
+
+		Step step;
+		step.word = best;
+		step.newLetters = problem.getWord(best).cipherMask & ~known;
+		known |= step.newLetters;
+		isWordUsed[best] = true;
+		for (int w = 0; w < problem.getNumWords(); w++)
+		{
+			const PreparedProblem::Word& word = problem.getWord(w);
+			if (!isWordCrib[w] && (word.cipherMask & step.newLetters) != 0 && (word.cipherMask & ~known) == 0 && word.numUntranslatable == 0)
+				step.checkedWords.push_back(w);
+		}
+		m_steps.push_back(step);
+	}
+}
+
+//O(C * P), C = number of candidates, P = distinct letters in the word. for each of the word's letters (in the
+//order of Word::letters), the chance that two of its candidates picked at random give that letter the same plain
+//letter. that's about the share of the candidates left once the key knows the letter
+static std::vector<double> getAgreementShares(const PreparedProblem::Word& word)
+{
+	std::vector<double> shares(word.letters.size(), 0);
+	if (word.candidates.empty())
+		return shares;
+	for (unsigned int i = 0; i < word.letters.size(); i++)
+	{
+		int counts[EnglishLetters::SIZE] = {};
+		for (unsigned int c = 0; c < word.candidates.size(); c++)
+			counts[word.pairs[word.candidates[c].firstPair + i].plain]++;
+		double total = static_cast<double>(word.candidates.size());
+		for (int p = 0; p < EnglishLetters::SIZE; p++)
+			shares[i] += (counts[p] / total) * (counts[p] / total);
+	}
+	return shares;
+}
+
+void SearchPlan::estimate(const PreparedProblem& problem, double& numNodes, double& numSolutions) const
+{
+	std::vector<std::vector<double>> shares(problem.getNumWords());
+	for (int w = 0; w < problem.getNumWords(); w++)
+		shares[w] = getAgreementShares(problem.getWord(w));
+
+	//branches is how many calls reach each step, and every one of them is a node
+	double branches = 1;
+	numNodes = 0;
+	unsigned int known = m_knownLetters;
+	int numKnown = 0;
+	for (unsigned int k = known; k != 0; k &= k - 1)
+		numKnown++;
+	for (unsigned int s = 0; s < m_steps.size() && branches > 0; s++)
+	{
+		numNodes += branches;
+		const PreparedProblem::Word& word = problem.getWord(m_steps[s].word);
+
+		//the candidates that agree with the known letters, and whose new letters go to plain letters nothing maps to yet
+		double survivors = static_cast<double>(word.candidates.size());
+		int numNew = 0;
+		for (unsigned int i = 0; i < word.letters.size(); i++)
+		{
+			if (known & (1u << word.letters[i]))
+				survivors *= shares[m_steps[s].word][i];
+			else
+			{
+				survivors *= static_cast<double>(EnglishLetters::SIZE - numKnown - numNew) / (EnglishLetters::SIZE - numNew);
+				numNew++;
+			}
+		}
+
+		//each other word this step finishes is a word about as often as one of its candidates would happen
+		//to agree with every one of its letters
+		for (unsigned int c = 0; c < m_steps[s].checkedWords.size(); c++)
+		{
+			int w = m_steps[s].checkedWords[c];
+			if (w == m_steps[s].word)
+				continue;
+			double chanceOfWord = static_cast<double>(problem.getWord(w).candidates.size());
+			for (unsigned int i = 0; i < shares[w].size(); i++)
+				chanceOfWord *= shares[w][i];
+			survivors *= std::min(1.0, chanceOfWord);
+		}
+
+		branches *= survivors;
+		known |= m_steps[s].newLetters;
+		numKnown += numNew;
+	}
+	numSolutions = branches;
+}
+
+//O(S * W), S = number of steps
+void SearchPlan::explain(const PreparedProblem& problem, std::ostream& out) const
+{
+	out << problem.getNumWords() << " distinct words, " << m_steps.size() << " steps";
+	if (m_knownLetters != 0)
+		out << ", letters known from the start: " << getLetters(m_knownLetters);
+	out << std::endl;
+	for (unsigned int s = 0; s < m_steps.size(); s++)
+	{
+		const PreparedProblem::Word& word = problem.getWord(m_steps[s].word);
+		out << "step " << s + 1 << ": " << word.text << " (" << word.candidates.size() << " candidates)";
+		out << ", new letters " << (m_steps[s].newLetters != 0 ? getLetters(m_steps[s].newLetters) : "none");
+		out << ", checks";
+		if (m_steps[s].checkedWords.empty())
+			out << " nothing";
+		for (unsigned int c = 0; c < m_steps[s].checkedWords.size(); c++)
+			out << (c == 0 ? " " : ", ") << problem.getWord(m_steps[s].checkedWords[c]).text;
+		out << std::endl;
+	}
+}
@@ -0,0 +1,44 @@
+#ifndef SEARCHPLAN_INCLUDED
+#define SEARCHPLAN_INCLUDED
+
+#include "PreparedProblem.h"
+#include <iosfwd>
+#include <vector>
+
+//the order crack() tries a message's words in, worked out before searching. every candidate of a word maps
+//exactly the word's cipher letters, so for an order that only looks at which letters are mapped, the letters
+//known at each depth of the search (and so the word picked there, and the words it finishes translating)
+//are the same down every branch. the search then just walks the steps instead of rescanning the words at each node
+class SearchPlan
+{
+public:
+	struct Step
+	{
+		//the word whose candidates are tried at this step
+		int word;
+		//cipher letters the word's candidates add to the key
+		unsigned int newLetters;
+		//the words (other than cribs) that are fully translated once this step's letters are mapped, and weren't before.
+		//these are the only ones to look up in the dictionary
+		std::vector<int> checkedWords;
+	};
+
+	//true if order only depends on which letters are mapped, so a plan can be made for it
+	static bool canPlan(CrackWordOrder order) { return order != CrackWordOrder::FewestCandidates; }
+	//O(W^2 * P), W = number of distinct words, P = distinct letters in each. knownLetters are mapped before the
+	//search starts (fixed letters and cribs), and isWordCrib[w] is true for words cribs translate
+	SearchPlan(const PreparedProblem& problem, CrackWordOrder order, unsigned int knownLetters, const std::vector<bool>& isWordCrib);
+	int getNumSteps() const { return static_cast<int>(m_steps.size()); }
+	const Step& getStep(int i) const { return m_steps[i]; }
+	//writes each step: its word, how many candidates the word has, the letters it adds and the words it checks
+	void explain(const PreparedProblem& problem, std::ostream& out) const;
+	//O(C * P), C = number of candidates of every word. guesses how many nodes following the plan takes, and how
+	//many keys survive it, without searching: each step keeps the share of its word's candidates that would
+	//agree with the letters already known, and then the share of those whose checked words come out as words
+	void estimate(const PreparedProblem& problem, double& numNodes, double& numSolutions) const;
+private:
+	unsigned int m_knownLetters;
+	std::vector<Step> m_steps;
+};
+
+#endif // SEARCHPLAN_INCLUDED
@@ -1,98 +1,607 @@
 #include "provided.h"
+#include "Alphabet.h"
 #include "MyHash.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include <fstream>
 #include <iostream>
-
-///////////// Given Helper Functions //////////////
-//hash for string
-unsigned int hash(const std::string& s)	
-{
-	return std::hash<std::string>()(s);
-}
-//hash for int
-unsigned int hash(const int& u)			
-{
-	return std::hash<int>()(u);
-}
-//hash for char
-unsigned int hash(const	char& c)		
-{
-	return std::hash<char>()(c);
-}
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 class WordListImpl
 {
 public:
 	WordListImpl();
-	bool loadWordList(std::string dictFilename);
+	~WordListImpl();
+	bool loadWordList(std::string dictFilename, int numThreads);
+	bool saveCompiledWordList(std::string filename);
+	void setLazyLoading(bool lazy) { m_isLazy = lazy; }
+	std::vector<WordListShardStats> getShardStats() const;
+	void setTableStatsOutput(std::ostream* out) { m_tableStatsOutput = out; }
+	void printTableStats(std::ostream& out) const;
 	bool contains(std::string word)	const;
 	std::vector<std::string> findCandidates(std::string cipherWord, std::string currTranslation) const;
+	bool addWord(std::string word);
+	bool removeWord(std::string word);
+	int applyDelta(std::string filename, std::vector<std::string>* changedWords);
+	void copyFrom(const WordListImpl& other);
 private:
-	MyHash<std::string, std::vector<std::string>> m_wordTable;
-	// the KeyType is std::string and will represent the letter pattern w all CAP letters (turtle = ABCADE)
-	// the ValueType is a vector of strings that holds all the words in the list that have that pattern
+	//the words sharing a pattern sit next to each other in a shard's patternWords, starting at firstWord
+	struct PatternBucket
+	{
+		int firstWord;
+		int numWords;
+	};
 
-	MyHash<std::string, bool> m_hasAllWords;
-	// the KeyType is std::string and represents each word found in the file
-	// the ValueType is a bool bc it is cheapest and doesn't matter
-	
-	std::string getLetterPattern(std::string) const;
+	//the tables over a shard's words as they were when it was loaded (or last merged, see mergeChanges).
+	//they never change once built, so every copy of the shard shares them
+	struct ShardTables
+	{
+		//the tables are written only while they're built, so there's no later insert to finish an incremental
+		//resize. they resize all at once instead
+		ShardTables()
+			: wordTable(0.5, false), hasAllWords(0.5, false)
+		{}
+
+		std::vector<std::string_view> patternWords;
+		//each pattern once, in the order their buckets sit in patternWords
+		std::vector<std::string_view> bucketPatterns;
+
+		MyHash<std::string_view, PatternBucket> wordTable;
+		// the KeyType is std::string_view and will represent the letter pattern w all CAP letters (turtle = ABCADE)
+		// the ValueType says where the words in the list that have that pattern are in patternWords
+
+		MyHash<std::string_view, int> hasAllWords;
+		// the KeyType is std::string_view and represents each word found in the file
+		// the ValueType is the word's spot in patternWords
+
+		//the text of words that were added before the tables were built, which some of the views point into
+		std::vector<std::shared_ptr<const std::string>> text;
+	};
+
+	//all the words of one length, and the tables over them. a pattern has the same length as its
+	//words, so every lookup only ever needs one shard. a shard is loaded (its tables built) either
+	//right away, or the first time a word of its length is looked up if the list is lazy
+	struct Shard
+	{
+		Shard(std::size_t length)
+			: wordLength(length), compiledWords(nullptr), compiledPatterns(nullptr), numCompiledWords(0), numWords(0),
+			  isResident(false), numLoads(0), numLookups(0)
+		{}
+
+		std::size_t wordLength;
+
+		//where the shard's words come from: lines of a text file (views into the word pool, not checked yet),
+		//or numCompiledWords words and their patterns packed back to back in a compiled file
+		std::vector<std::string_view> lines;
+		const char* compiledWords;
+		const char* compiledPatterns;
+		int numCompiledWords;
+
+		//set once the shard is loaded, and replaced (never changed) when changes are merged into it
+		std::shared_ptr<const ShardTables> tables;
+
+		//what addWord and removeWord changed since the tables were built. changedBuckets has the whole word list
+		//of each pattern they touched, which stands in for the pattern's bucket in the tables, and changedWords
+		//says for each word they touched whether it's in the list now. a copy of the shard shares the lists
+		//until one side changes one, so a change only ever copies the one bucket it touches
+		MyHash<std::string_view, std::shared_ptr<std::vector<std::string_view>>> changedBuckets;
+		MyHash<std::string_view, bool> changedWords;
+		//the text of the added words and of changedBuckets' patterns. each string is held by pointer, so it
+		//never moves once it's there, and a copy of the shard shares them instead of copying them
+		std::vector<std::shared_ptr<const std::string>> addedText;
+		int numWords;
+
+		//isResident is only set (under loadMutex) once the tables are finished, so a lookup that sees it
+		//set can read them without locking. lines and numLoads only change under loadMutex too
+		std::atomic<bool> isResident;
+		std::mutex loadMutex;
+		int numLoads;
+		mutable std::atomic<long long> numLookups;
+	};
+
+	//every word and every pattern in a text list's tables is a view into one of these two buffers, so loading
+	//doesn't allocate a string per word. wordPool is the file itself (lowercased in place), and
+	//patternPool is the same size, holding each word's letter pattern at the same offset as the word.
+	//a compiled list is mapped instead, and its tables are views into the mapping
+	struct WordSource
+	{
+		std::string wordPool;
+		std::string patternPool;
+		MappedFile compiledFile;
+	};
+	//shared with copies of the list (see copyFrom), whose shards still point into it after this one loads another
+	std::shared_ptr<WordSource> m_source;
+
+	//m_shards[L] holds the words of length L (nullptr if there are none). a copy of the list shares them
+	//until one side changes a shard, which first gets its own copy of it (see getShardForUpdate)
+	std::vector<std::shared_ptr<Shard>> m_shards;
+	//once a shard has had this many words changed, they're merged into its tables, so copying the shard
+	//(which copies the changes but not the tables) stays cheap
+	static const int MAX_CHANGED_WORDS = 1024;
+	bool m_isLazy;
+	//where to print the tables' stats after each load. nullptr (the default) also leaves their counting off
+	std::ostream* m_tableStatsOutput;
+
+	void clearShards();
+	bool splitTextIntoShards();
+	bool splitCompiledIntoShards();
+	const Shard* getResidentShard(std::size_t length) const;
+	void loadShard(Shard* shard) const;
+	//the tables over the given words (each with its pattern at the same spot). a word that's there twice goes in once
+	std::shared_ptr<ShardTables> buildTables(const std::vector<std::string_view>& words, const std::vector<std::string_view>& patterns) const;
+	//a copy of a resident shard that shares its tables, with its own copy of the changes to them
+	std::shared_ptr<Shard> copyShard(const Shard& shard) const;
+	//returns the shard for words of the given length with its tables built, making an empty one if there are none yet.
+	//the shard is this list's own, copied first if a copy of the list shares it
+	Shard* getShardForUpdate(std::size_t length);
+	//returns the words with the given pattern in a shard this list owns, which the caller can change. the first
+	//change to a pattern copies its bucket out of the tables, and a list shared with a copy of the shard is copied
+	std::vector<std::string_view>& getBucketForUpdate(Shard* shard, const std::string& pattern);
+	//builds new tables over the shard's words as they are now, and forgets the changes
+	void mergeChanges(Shard* shard) const;
+	//the shard's words in bucket order, and if patterns isn't nullptr, each word's pattern at the same spot
+	std::vector<std::string_view> getLiveWords(const Shard* shard, std::vector<std::string_view>* patterns = nullptr) const;
+	//sets words to where the shard's words with the given pattern are, and numWords to how many there are
+	static void getBucket(const Shard* shard, std::string_view pattern, const std::string_view*& words, int& numWords);
+	static bool hasWord(const Shard* shard, std::string_view word);
+	//lowercases word and returns true if it is made of letters and apostrophes only
+	static bool normalizeWord(std::string& word);
 };
 
-//does not need to do anything, bc it will allow the MyHash obj to default construct
+//the file starts with this, then the number of shards, then (length, numWords, offset) for each shard.
+//a shard's data is its numWords words packed back to back, then their patterns packed the same way
+static const char COMPILED_MAGIC[8] = { 'P', '4', 'D', 'I', 'C', 'T', '1', '\n' };
+
+//the shards are eager until someone asks for lazy loading
 WordListImpl::WordListImpl()
+	: m_source(std::make_shared<WordSource>()), m_isLazy(false), m_tableStatsOutput(nullptr)
 {}
 
-//O(W) where W is the number of words in file
-bool WordListImpl::loadWordList(std::string dictFilename)
+WordListImpl::~WordListImpl()
 {
-	//reset both tables
-	m_wordTable.reset();	
-	m_hasAllWords.reset();
+	clearShards();
+}
 
-	std::ifstream infile(dictFilename);
-	//if it didn't find the file, return false
-	if (!infile)		
-		return false;
+//O(W / T) where W is the number of words in file and T the number of threads (O(1) per shard if lazy)
+//shards are loaded in parallel. each shard keeps its words in file order, so the tables end up
+//exactly as a one-thread load leaves them
+bool WordListImpl::loadWordList(std::string dictFilename, int numThreads)
+{
+	//throw out the old shards. the old text goes once no copy of the list uses it anymore
+	clearShards();
+	m_source = std::make_shared<WordSource>();
+	MappedFile& compiledFile = m_source->compiledFile;
 
-	//get every line (which has one word each), and for each word...
-	std::string s;					
-	while (getline(infile, s))		
-	{
-		//if the word has any character that is not a letter or apostrophe, go to next line in the text file, otherwise make it lowercase 
-		bool isGood = true;							
-		for (unsigned int i = 0; i < s.size(); i++)	
-		{											
-			if (!isalpha(s[i]) && s[i] != '\'')		
-			{										
-				isGood = false;							
-				break;								
-			}										
-			s[i] = tolower(s[i]);					
-		}											
-		if (!isGood)								
-			continue;								
-
-		//if the letter pattern of the word hasnt been seen before
-		std::vector<std::string>* vp = m_wordTable.find(getLetterPattern(s));
-		if (vp == nullptr)	
+	//a compiled list starts with the magic bytes, anything else is read as text
+	if (!compiledFile.open(dictFilename))
+		return false;
+	if (compiledFile.size() >= sizeof(COMPILED_MAGIC) && std::memcmp(compiledFile.data(), COMPILED_MAGIC, sizeof(COMPILED_MAGIC)) == 0)
+	{
+		if (!splitCompiledIntoShards())
 		{
-			//create a new vector with the word and associate it with the letter pattern
-			std::vector<std::string> newVector;						
-			newVector.push_back(s);									
-			m_wordTable.associate(getLetterPattern(s), newVector);	
+			clearShards();
+			compiledFile.close();
+			return false;
 		}
-		//if the pattern has been seen
-		else				
-			//add the word to the vector associated with the pattern
-			vp->push_back(s);	
+	}
+	else
+	{
+		compiledFile.close();
+		//read the whole file in one go, straight into the word pool. if it didn't find the file, return false
+		std::ifstream infile(dictFilename);
+		if (!infile)
+			return false;
+		m_source->wordPool.assign(std::istreambuf_iterator<char>(infile), std::istreambuf_iterator<char>());
+		m_source->patternPool.assign(m_source->wordPool.size(), '\0');
+		splitTextIntoShards();
+	}
 
-		//then add the word to this vector regardless of whether it has a new or old pattern
-		m_hasAllWords.associate(s, true);	
+	//a lazy list stops here, and each shard is loaded when it's first needed
+	if (m_isLazy)
+	{
+		if (m_tableStatsOutput != nullptr)
+			printTableStats(*m_tableStatsOutput);
+		return true;
 	}
 
+	//0 (or less) means use every core
+	if (numThreads <= 0)
+		numThreads = std::thread::hardware_concurrency();
+	if (numThreads <= 0)
+		numThreads = 1;
+
+	//otherwise load every shard now. each thread keeps taking the next unloaded shard, biggest first so
+	//one long shard doesn't end up last
+	std::vector<Shard*> shardsToLoad;
+	for (unsigned int L = 0; L < m_shards.size(); L++)
+		if (m_shards[L] != nullptr)
+			shardsToLoad.push_back(m_shards[L].get());
+	std::sort(shardsToLoad.begin(), shardsToLoad.end(), [](const Shard* a, const Shard* b)
+	{
+		return a->lines.size() + a->numCompiledWords > b->lines.size() + b->numCompiledWords;
+	});
+	std::atomic<int> nextShard(0);
+	auto loadShards = [this, &shardsToLoad, &nextShard]()
+	{
+		for (int i = nextShard++; i < static_cast<int>(shardsToLoad.size()); i = nextShard++)
+			loadShard(shardsToLoad[i]);
+	};
+	std::vector<std::thread> workers;
+	for (int t = 1; t < numThreads && t < static_cast<int>(shardsToLoad.size()); t++)
+		workers.push_back(std::thread(loadShards));
+	loadShards();
+	for (unsigned int t = 0; t < workers.size(); t++)
+		workers[t].join();
+
+	if (m_tableStatsOutput != nullptr)
+		printTableStats(*m_tableStatsOutput);
+
 	//return true because it was successful
-	return true;	
+	return true;
+}
+
+//O(W), loads any shards that aren't resident yet
+//writes the list in compiled form, which loads without parsing and lets each shard be mapped on its own
+bool WordListImpl::saveCompiledWordList(std::string filename)
+{
+	std::ofstream outfile(filename, std::ios::binary);
+	if (!outfile)
+		return false;
+
+	//writes x as 'bytes' little-endian bytes
+	auto writeNumber = [&outfile](unsigned long long x, int bytes)
+	{
+		for (int i = 0; i < bytes; i++)
+			outfile.put(static_cast<char>((x >> (8 * i)) & 0xFF));
+	};
+
+	//the header: magic, number of shards, then one entry per shard
+	std::vector<std::vector<std::string_view>> shardWords;
+	std::vector<unsigned int> lengths;
+	for (unsigned int L = 0; L < m_shards.size(); L++)
+	{
+		const Shard* shard = getResidentShard(L);
+		if (shard != nullptr)
+		{
+			shardWords.push_back(getLiveWords(shard));
+			lengths.push_back(L);
+		}
+	}
+	outfile.write(COMPILED_MAGIC, sizeof(COMPILED_MAGIC));
+	writeNumber(shardWords.size(), 4);
+	unsigned long long offset = sizeof(COMPILED_MAGIC) + 4 + shardWords.size() * 16;
+	for (unsigned int i = 0; i < shardWords.size(); i++)
+	{
+		writeNumber(lengths[i], 4);
+		writeNumber(shardWords[i].size(), 4);
+		writeNumber(offset, 8);
+		offset += 2ull * lengths[i] * shardWords[i].size();
+	}
+
+	//then each shard's words in pattern-bucket order (so reloading rebuilds the same buckets), then their patterns
+	std::vector<char> pattern;
+	for (unsigned int i = 0; i < shardWords.size(); i++)
+	{
+		for (unsigned int w = 0; w < shardWords[i].size(); w++)
+			outfile.write(shardWords[i][w].data(), lengths[i]);
+		pattern.resize(lengths[i] + 1);
+		for (unsigned int w = 0; w < shardWords[i].size(); w++)
+		{
+			EnglishLetters::getLetterPattern(shardWords[i][w].data(), lengths[i], pattern.data());
+			outfile.write(pattern.data(), lengths[i]);
+		}
+	}
+	return static_cast<bool>(outfile);
+}
+
+//O(S), S = number of shards
+std::vector<WordListShardStats> WordListImpl::getShardStats() const
+{
+	std::vector<WordListShardStats> stats;
+	for (unsigned int L = 0; L < m_shards.size(); L++)
+	{
+		Shard* shard = m_shards[L].get();
+		if (shard == nullptr)
+			continue;
+		//another thread could be loading the shard, which swaps its lines out and counts the load
+		std::lock_guard<std::mutex> lock(shard->loadMutex);
+		WordListShardStats s;
+		s.wordLength = L;
+		s.isResident = shard->isResident;
+		//before it's loaded, a text shard only knows how many lines it has
+		s.numWords = shard->isResident ? shard->numWords : shard->lines.size() + shard->numCompiledWords;
+		s.numLoads = shard->numLoads;
+		s.numLookups = shard->numLookups;
+		stats.push_back(s);
+	}
+	return stats;
+}
+
+//adds one table's stats into a total over several tables
+static void addTableStats(MyHashStats& total, const MyHashStats& stats)
+{
+	total.numItems += stats.numItems;
+	total.numBuckets += stats.numBuckets;
+	if (total.bucketOccupancy.size() < stats.bucketOccupancy.size())
+	{
+		total.bucketOccupancy.resize(stats.bucketOccupancy.size(), 0);
+		total.chainLengths.resize(stats.chainLengths.size(), 0);
+	}
+	for (unsigned int k = 0; k < stats.bucketOccupancy.size(); k++)
+	{
+		total.bucketOccupancy[k] += stats.bucketOccupancy[k];
+		total.chainLengths[k] += stats.chainLengths[k];
+	}
+	//the averages are weighted by how many finds each table saw
+	if (total.numHits + stats.numHits > 0)
+		total.averageHitProbes = (total.averageHitProbes * total.numHits + stats.averageHitProbes * stats.numHits) / (total.numHits + stats.numHits);
+	if (total.numMisses + stats.numMisses > 0)
+		total.averageMissProbes = (total.averageMissProbes * total.numMisses + stats.averageMissProbes * stats.numMisses) / (total.numMisses + stats.numMisses);
+	total.numHits += stats.numHits;
+	total.numMisses += stats.numMisses;
+	total.maxHitProbes = std::max(total.maxHitProbes, stats.maxHitProbes);
+	total.maxMissProbes = std::max(total.maxMissProbes, stats.maxMissProbes);
+	total.numRehashes += stats.numRehashes;
+	total.rehashSeconds += stats.rehashSeconds;
+	total.bytesHeld += stats.bytesHeld;
+}
+
+static void printTableStats(std::ostream& out, const char* name, const MyHashStats& stats)
+{
+	out << name << ": " << stats.numItems << " items in " << stats.numBuckets << " buckets, " << stats.bytesHeld << " bytes" << std::endl;
+	out << "  buckets holding k items:";
+	for (unsigned int k = 0; k < stats.bucketOccupancy.size(); k++)
+		out << " " << k << ":" << stats.bucketOccupancy[k];
+	out << std::endl << "  items in a chain of length k:";
+	for (unsigned int k = 1; k < stats.chainLengths.size(); k++)
+		out << " " << k << ":" << stats.chainLengths[k];
+	out << std::endl << "  " << stats.numHits << " hits averaging " << stats.averageHitProbes << " probes (max " << stats.maxHitProbes << "), "
+		<< stats.numMisses << " misses averaging " << stats.averageMissProbes << " probes (max " << stats.maxMissProbes << ")" << std::endl;
+	out << "  " << stats.numRehashes << " rehashes taking " << stats.rehashSeconds * 1000 << " ms" << std::endl;
+}
+
+//O(B + W), B = buckets in all the resident shards' tables
+//prints the stats of the two kinds of table, each summed over every resident shard
+void WordListImpl::printTableStats(std::ostream& out) const
+{
+	MyHashStats patternStats;
+	MyHashStats wordStats;
+	int numResident = 0;
+	for (unsigned int L = 0; L < m_shards.size(); L++)
+	{
+		if (m_shards[L] == nullptr || !m_shards[L]->isResident)
+			continue;
+		addTableStats(patternStats, m_shards[L]->tables->wordTable.getStats());
+		addTableStats(wordStats, m_shards[L]->tables->hasAllWords.getStats());
+		numResident++;
+	}
+	out << "word list tables (" << numResident << " resident shards)" << std::endl;
+	::printTableStats(out, "pattern table", patternStats);
+	::printTableStats(out, "word table", wordStats);
+}
+
+//O(S). each shard is freed once no copy of the list shares it
+void WordListImpl::clearShards()
+{
+	m_shards.clear();
+}
+
+//O(N), N = number of bytes in the file
+//sorts every line of the word pool into the shard for its length, without checking or indexing it yet
+bool WordListImpl::splitTextIntoShards()
+{
+	const std::string& wordPool = m_source->wordPool;
+	std::size_t lineStart = 0;
+	while (lineStart < wordPool.size())
+	{
+		//find the end of this line (the last line might not have a newline)
+		std::size_t lineEnd = wordPool.find('\n', lineStart);
+		if (lineEnd == std::string::npos)
+			lineEnd = wordPool.size();
+		std::size_t length = lineEnd - lineStart;
+		//a blank line isn't a word (and a compiled list can't have a shard of length 0)
+		if (length == 0)
+		{
+			lineStart = lineEnd + 1;
+			continue;
+		}
+
+		if (length >= m_shards.size())
+			m_shards.resize(length + 1, nullptr);
+		if (m_shards[length] == nullptr)
+			m_shards[length] = std::make_shared<Shard>(length);
+		m_shards[length]->lines.push_back(std::string_view(&wordPool[lineStart], length));
+		lineStart = lineEnd + 1;
+	}
+	return true;
+}
+
+//O(S), S = number of shards. only the header is read, the shards' pages are touched when they're loaded
+bool WordListImpl::splitCompiledIntoShards()
+{
+	const MappedFile& compiledFile = m_source->compiledFile;
+	const unsigned char* data = reinterpret_cast<const unsigned char*>(compiledFile.data());
+	std::size_t size = compiledFile.size();
+
+	//reads a 'bytes'-byte little-endian number at pos
+	auto readNumber = [data](std::size_t pos, int bytes)
+	{
+		unsigned long long x = 0;
+		for (int i = 0; i < bytes; i++)
+			x |= static_cast<unsigned long long>(data[pos + i]) << (8 * i);
+		return x;
+	};
+
+	std::size_t pos = sizeof(COMPILED_MAGIC);
+	if (size < pos + 4)
+		return false;
+	unsigned long long numShards = readNumber(pos, 4);
+	pos += 4;
+	if (size < pos + numShards * 16)
+		return false;
+	for (unsigned long long i = 0; i < numShards; i++, pos += 16)
+	{
+		unsigned long long length = readNumber(pos, 4);
+		unsigned long long numWords = readNumber(pos + 4, 4);
+		unsigned long long offset = readNumber(pos + 8, 8);
+		//if a shard claims bytes past the end of the file (or a length twice), the file is bad. the size check
+		//divides instead of multiplying, so a huge length or word count can't overflow its way past it, and
+		//a length longer than the file is turned away before it can size m_shards
+		if (length == 0 || length > size || offset > size || numWords > (size - offset) / (2 * length))
+			return false;
+		if (length >= m_shards.size())
+			m_shards.resize(length + 1, nullptr);
+		if (m_shards[length] != nullptr)
+			return false;
+		m_shards[length] = std::make_shared<Shard>(length);
+		m_shards[length]->compiledWords = compiledFile.data() + offset;
+		m_shards[length]->compiledPatterns = compiledFile.data() + offset + length * numWords;
+		m_shards[length]->numCompiledWords = static_cast<int>(numWords);
+	}
+	return true;
+}
+
+//O(1), or O(W) the first time a shard of a lazy list is needed (W = words in it)
+//returns the shard for words of the given length with its tables built, or nullptr if there are no such words
+const WordListImpl::Shard* WordListImpl::getResidentShard(std::size_t length) const
+{
+	if (length >= m_shards.size() || m_shards[length] == nullptr)
+		return nullptr;
+	Shard* shard = m_shards[length].get();
+	if (!shard->isResident)
+		loadShard(shard);
+	return shard;
+}
+
+//O(W), W = number of words in the shard
+//builds the shard's tables. the word and pattern pools are only ever written at the shard's own lines,
+//so shards can load at the same time on different threads (and from different copies of the list)
+void WordListImpl::loadShard(Shard* shard) const
+{
+	std::lock_guard<std::mutex> lock(shard->loadMutex);
+	//another thread might have loaded it while this one waited
+	if (shard->isResident)
+		return;
+
+	//collect the shard's good words (and their patterns), in file order
+	std::vector<std::string_view> words;
+	std::vector<std::string_view> patterns;
+	if (shard->compiledWords != nullptr)
+	{
+		//a compiled shard was already checked and has its patterns
+		std::size_t length = shard->wordLength;
+		words.reserve(shard->numCompiledWords);
+		patterns.reserve(shard->numCompiledWords);
+		for (int i = 0; i < shard->numCompiledWords; i++)
+		{
+			words.push_back(std::string_view(shard->compiledWords + i * length, length));
+			patterns.push_back(std::string_view(shard->compiledPatterns + i * length, length));
+		}
+	}
+	else
+	{
+		words.reserve(shard->lines.size());
+		patterns.reserve(shard->lines.size());
+		for (unsigned int l = 0; l < shard->lines.size(); l++)
+		{
+			//the line lives in the word pool, which this (const) function lowercases in place
+			char* s = const_cast<char*>(shard->lines[l].data());
+			std::size_t length = shard->lines[l].size();
+			std::size_t offset = s - m_source->wordPool.data();
+
+			//if the word has any character that is not a letter or apostrophe, go to next line, otherwise make it lowercase
+			bool isGood = true;
+			for (std::size_t i = 0; i < length; i++)
+			{
+				if (!EnglishLetters::isWordCharacter(s[i]))
+				{
+					isGood = false;
+					break;
+				}
+				s[i] = EnglishLetters::toLower(s[i]);
+			}
+			if (!isGood)
+				continue;
+
+			char* pattern = const_cast<char*>(m_source->patternPool.data()) + offset;
+			EnglishLetters::getLetterPattern(s, length, pattern);
+			words.push_back(std::string_view(s, length));
+			patterns.push_back(std::string_view(pattern, length));
+		}
+	}
+
+	shard->tables = buildTables(words, patterns);
+	shard->numWords = shard->tables->hasAllWords.getNumItems();
+
+	//the lines aren't needed anymore, and now lookups can use the shard
+	std::vector<std::string_view>().swap(shard->lines);
+	shard->numLoads++;
+	shard->isResident = true;
+}
+
+//O(W), W = number of words
+std::shared_ptr<WordListImpl::ShardTables> WordListImpl::buildTables(const std::vector<std::string_view>& words, const std::vector<std::string_view>& patterns) const
+{
+	std::shared_ptr<ShardTables> tables = std::make_shared<ShardTables>();
+	//count from the start, so the rehashes while the tables grow are in the stats
+	if (m_tableStatsOutput != nullptr)
+	{
+		tables->wordTable.setStatsEnabled(true);
+		tables->hasAllWords.setStatsEnabled(true);
+	}
+
+	//size the membership table up front now that we know how many words there are. a word the list has
+	//twice only goes in once (its spot gets filled in below, -1 means it's new)
+	tables->hasAllWords.reserve(words.size());
+	std::vector<int*> spotOfWord(words.size(), nullptr);
+	int numUniqueWords = 0;
+	for (unsigned int w = 0; w < words.size(); w++)
+	{
+		int* spot = tables->hasAllWords.emplace(words[w], -1);
+		if (*spot != -1)
+			continue;
+		*spot = 0;
+		spotOfWord[w] = spot;
+		numUniqueWords++;
+	}
+
+	//first count the words with each pattern, remembering each word's bucket for the second pass
+	std::vector<PatternBucket*> bucketOfWord(words.size());
+	for (unsigned int w = 0; w < words.size(); w++)
+	{
+		if (spotOfWord[w] == nullptr)
+			continue;
+		//a pattern that hasnt been seen before starts out with no words and no place yet
+		PatternBucket* bucket = tables->wordTable.emplace(patterns[w], PatternBucket{ -1, 0 });
+		bucket->numWords++;
+		bucketOfWord[w] = bucket;
+	}
+
+	//then give each pattern its spot (in order of first appearance) and drop every word into place, in file order
+	tables->patternWords.resize(numUniqueWords);
+	int nextFreeSpot = 0;
+	for (unsigned int w = 0; w < words.size(); w++)
+	{
+		if (spotOfWord[w] == nullptr)
+			continue;
+		PatternBucket* bucket = bucketOfWord[w];
+		if (bucket->firstWord == -1)
+		{
+			tables->bucketPatterns.push_back(patterns[w]);
+			bucket->firstWord = nextFreeSpot;
+			nextFreeSpot += bucket->numWords;
+			bucket->numWords = 0;
+		}
+		*spotOfWord[w] = bucket->firstWord + bucket->numWords;
+		tables->patternWords[bucket->firstWord + bucket->numWords] = words[w];
+		bucket->numWords++;
+	}
+	return tables;
 }
 
 //O(1)
@@ -100,13 +609,14 @@ bool WordListImpl::contains(std::string word) const
 {
 	//convert word to lowercase to make this function case-insensitive
 	for (unsigned int i = 0; i < word.size(); i++)	
-		word[i] = tolower(word[i]);					
+		word[i] = EnglishLetters::toLower(word[i]);					
 	
-	//try to find the word. //if it didn't, return false. if it did, return true
-	const bool* vp = m_hasAllWords.find(word);	
-	if (vp == nullptr)	
-		return false;	
-	return true;		
+	//try to find the word in the shard for its length. //if it didn't, return false. if it did, return true
+	const Shard* shard = getResidentShard(word.size());
+	if (shard == nullptr)
+		return false;
+	shard->numLookups++;
+	return hasWord(shard, std::string_view(word));
 }
 
 //O(Q), Q = numWords w right pattern
@@ -124,17 +634,17 @@ std::vector<std::string> WordListImpl::findCandidates(std::string cipherWord, st
 	for (unsigned int l = 0; l < cipherWord.size(); l++)
 	{													
 		//change the letters to lowercase because it's case insensitive
-		cipherWord[l] = tolower(cipherWord[l]);				
-		currTranslation[l] = tolower(currTranslation[l]);	
+		cipherWord[l] = EnglishLetters::toLower(cipherWord[l]);				
+		currTranslation[l] = EnglishLetters::toLower(currTranslation[l]);	
 
 		//check that cipherWord has the right characters. if not, set var to bad, and break loop
-		if (!isalpha(cipherWord[l]) && cipherWord[l] != '\'')	 
+		if (!EnglishLetters::isWordCharacter(cipherWord[l]))	 
 		{														
 			isGood = false;										
 			break;												
 		}
 		//check that currTranslation has the right characters. if not, set var to bad, and break loop
-		if (!isalpha(currTranslation[l]) && currTranslation[l] != '\'' && currTranslation[l] != '?')	
+		if (!EnglishLetters::isWordCharacter(currTranslation[l]) && currTranslation[l] != EnglishLetters::UNKNOWN)	
 		{																								
 			isGood = false;																				
 			break;																						
@@ -145,23 +655,30 @@ std::vector<std::string> WordListImpl::findCandidates(std::string cipherWord, st
 		return std::vector<std::string>();	
 
 	//if no words in the dictionary share cipherWords pattern, return empty vector
-	const std::vector<std::string>* vp = m_wordTable.find(getLetterPattern(cipherWord));	
-	if (vp == nullptr)																		
-		return std::vector<std::string>();													
+	const Shard* shard = getResidentShard(cipherWord.size());
+	if (shard == nullptr)
+		return std::vector<std::string>();
+	shard->numLookups++;
+	std::string pattern = EnglishLetters::getLetterPattern(cipherWord);
+	const std::string_view* words;
+	int numWords;
+	getBucket(shard, std::string_view(pattern), words, numWords);
+	if (numWords == 0)
+		return std::vector<std::string>();
 
-	//otherwise, vp points to the vector of words with the right letter pattern
-	//for each word in the vector associated with the right pattern
-	for (unsigned int i = 0; i < (*vp).size(); i++)	
+	//otherwise, words says where the words with the right letter pattern are
+	//for each word with the right pattern
+	for (int i = 0; i < numWords; i++)
 	{
 		bool shouldAddWord = true;
-		std::string currWord = (*vp)[i];
+		std::string_view currWord = words[i];
 		//for each letter in this word
 		for (unsigned int j = 0; j < currWord.size(); j++)	
 		{
 			//if currTranslation[j] is a letter: return empty if currWord[j] isn't a letter, else go to next word if currWord[j] != currTranslation[i]
-			if (isalpha(currTranslation[j]))				 
+			if (EnglishLetters::isLetter(currTranslation[j]))				 
 			{												
-				if (!isalpha(cipherWord[j]))						
+				if (!EnglishLetters::isLetter(cipherWord[j]))						
 					return std::vector<std::string>();		
 				if (currTranslation[j] != currWord[j])				
 				{											
@@ -170,17 +687,17 @@ std::vector<std::string> WordListImpl::findCandidates(std::string cipherWord, st
 				}
 			}
 			//if currTranslation[j] is a '?': return empty if cipherWord[j] isn't a letter
-			else if (currTranslation[j] == '?')			
+			else if (currTranslation[j] == EnglishLetters::UNKNOWN)			
 			{											
-				if (!isalpha(cipherWord[j]))					
+				if (!EnglishLetters::isLetter(cipherWord[j]))					
 					return std::vector<std::string>();	
 			}
 			//if currTranslation[j] is a ': return empty if cipherWord[j] != ', else go to next word if currWord[j] != '
-			else if (currTranslation[j] == '\'')		
+			else if (EnglishLetters::isWordPunctuation(currTranslation[j]))		
 			{											
-				if (cipherWord[j] != '\'')						
+				if (!EnglishLetters::isWordPunctuation(cipherWord[j]))						
 					return std::vector<std::string>();	
-				if (currWord[j] != '\'')						
+				if (!EnglishLetters::isWordPunctuation(currWord[j]))						
 				{										
 					shouldAddWord = false;				
 					break;								
@@ -188,8 +705,8 @@ std::vector<std::string> WordListImpl::findCandidates(std::string cipherWord, st
 			}
 		}
 		//if the word didn't have any issues, add it to the vector to return at the end
-		if (shouldAddWord)								
-			vectorToFillAndReturn.push_back(currWord);	
+		if (shouldAddWord)
+			vectorToFillAndReturn.push_back(std::string(currWord));
 	}
 	//after getting through all words, return vector of potential words
 	return vectorToFillAndReturn;	
@@ -197,39 +714,234 @@ std::vector<std::string> WordListImpl::findCandidates(std::string cipherWord, st
 
 
 //O(L), L = length of word
-std::string WordListImpl::getLetterPattern(std::string word) const 
+bool WordListImpl::normalizeWord(std::string& word)
 {
-	//change the input to all lowercase so its cap-insensitive
-	for (unsigned int i = 0; i < word.size(); i++)	
-		word[i] = tolower(word[i]);					
+	if (word.empty())
+		return false;
+	for (unsigned int i = 0; i < word.size(); i++)
+	{
+		if (!EnglishLetters::isWordCharacter(word[i]))
+			return false;
+		word[i] = EnglishLetters::toLower(word[i]);
+	}
+	return true;
+}
 
-	//hash table to keep track of characters already seen and their pattern pairing
-	MyHash<char, char> charsSeen;		
-	//string to build to return at end
-	std::string letterPatternToReturn;	
+//O(1), or O(K) if the shard has to be copied first (K = words changed since its tables were built),
+//or O(W) if it has to be loaded first (W = words in it)
+WordListImpl::Shard* WordListImpl::getShardForUpdate(std::size_t length)
+{
+	if (length >= m_shards.size())
+		m_shards.resize(length + 1, nullptr);
+	//a new length starts as a shard with nothing loaded
+	if (m_shards[length] == nullptr)
+		m_shards[length] = std::make_shared<Shard>(length);
+	if (!m_shards[length]->isResident)
+		loadShard(m_shards[length].get());
+	//only lists hold shards, so if no other list holds this one nothing else can be reading it
+	if (m_shards[length].use_count() > 1)
+		m_shards[length] = copyShard(*m_shards[length]);
+	return m_shards[length].get();
+}
 
-	//creates string of CAP LETTERS and an int to keep track of next letter to use to code pattern
-	std::string CAPLetters = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";	
-	int nextCAPLetterToUseIndex = 0;						
+//O(K), K = words changed since the shard's tables were built. the tables themselves are shared
+std::shared_ptr<WordListImpl::Shard> WordListImpl::copyShard(const Shard& shard) const
+{
+	std::shared_ptr<Shard> copy = std::make_shared<Shard>(shard.wordLength);
+	//the views all point into the word source or the text the tables and addedText hold, which the copy keeps alive
+	copy->tables = shard.tables;
+	shard.changedBuckets.forEach([&copy](std::string_view pattern, const std::shared_ptr<std::vector<std::string_view>>& words)
+	{
+		copy->changedBuckets.associate(pattern, words);
+	});
+	copy->changedWords.reserve(shard.changedWords.getNumItems());
+	shard.changedWords.forEach([&copy](std::string_view word, bool isInList)
+	{
+		copy->changedWords.associate(word, isInList);
+	});
+	copy->addedText = shard.addedText;
+	copy->numWords = shard.numWords;
+	copy->numLoads = shard.numLoads;
+	copy->numLookups = shard.numLookups.load();
+	copy->isResident = true;
+	return copy;
+}
 
-	//for each letter in word
-	for (unsigned int i = 0; i < word.size(); i++)	
+//O(1), or O(B) the first time the pattern changes or when a copy of the shard shares its words (B = words with the pattern)
+std::vector<std::string_view>& WordListImpl::getBucketForUpdate(Shard* shard, const std::string& pattern)
+{
+	std::shared_ptr<std::vector<std::string_view>>* changed = shard->changedBuckets.find(std::string_view(pattern));
+	if (changed == nullptr)
 	{
-		//if the letter hasn't been seen yet
-		if (charsSeen.find(word[i]) == nullptr)	
+		//the tables' bucket is copied out, under a pattern whose text the shard keeps
+		const std::string_view* words;
+		int numWords;
+		getBucket(shard, std::string_view(pattern), words, numWords);
+		std::shared_ptr<std::vector<std::string_view>> bucket = std::make_shared<std::vector<std::string_view>>(words, words + numWords);
+		shard->addedText.push_back(std::make_shared<const std::string>(pattern));
+		changed = shard->changedBuckets.emplace(std::string_view(*shard->addedText.back()), std::move(bucket));
+	}
+	else if (changed->use_count() > 1)
+		*changed = std::make_shared<std::vector<std::string_view>>(**changed);
+	return **changed;
+}
+
+//O(W), W = words in the shard
+void WordListImpl::mergeChanges(Shard* shard) const
+{
+	std::vector<std::string_view> patterns;
+	std::vector<std::string_view> words = getLiveWords(shard, &patterns);
+	std::shared_ptr<ShardTables> tables = buildTables(words, patterns);
+	//the new tables point into the old ones' text and the added text, so they hold on to both
+	tables->text = shard->tables->text;
+	tables->text.insert(tables->text.end(), shard->addedText.begin(), shard->addedText.end());
+	shard->tables = tables;
+	shard->changedBuckets.reset();
+	shard->changedWords.reset();
+	shard->addedText.clear();
+}
+
+//O(S), S = number of shards. nothing is copied until a shard changes
+void WordListImpl::copyFrom(const WordListImpl& other)
+{
+	m_source = other.m_source;
+	m_shards = other.m_shards;
+	m_isLazy = other.m_isLazy;
+	m_tableStatsOutput = other.m_tableStatsOutput;
+}
+
+//O(L + B), L = length of word, B = words with its pattern, plus O(K) if its shard is shared with a copy of the
+//list (K = words changed since the shard's tables were built, at most MAX_CHANGED_WORDS). every
+//MAX_CHANGED_WORDS changes to a shard also merge them into its tables in O(W), W = words in the shard
+bool WordListImpl::addWord(std::string word)
+{
+	if (!normalizeWord(word))
+		return false;
+	//a word that's already there doesn't change anything, so the shard isn't taken for updating yet
+	const Shard* current = getResidentShard(word.size());
+	if (current != nullptr && hasWord(current, std::string_view(word)))
+		return false;
+	Shard* shard = getShardForUpdate(word.size());
+
+	//keep the word where views of it stay good
+	std::vector<std::string_view>& bucket = getBucketForUpdate(shard, EnglishLetters::getLetterPattern(word));
+	shard->addedText.push_back(std::make_shared<const std::string>(word));
+	bucket.push_back(std::string_view(*shard->addedText.back()));
+	shard->changedWords.associate(bucket.back(), true);
+	shard->numWords++;
+	if (shard->changedWords.getNumItems() > MAX_CHANGED_WORDS)
+		mergeChanges(shard);
+	return true;
+}
+
+//O(L + B), plus O(K) and every so often O(W), like addWord
+//the word's spot is filled by the last word of its bucket, which is then one shorter
+bool WordListImpl::removeWord(std::string word)
+{
+	if (!normalizeWord(word))
+		return false;
+	const Shard* current = getResidentShard(word.size());
+	if (current == nullptr || !hasWord(current, std::string_view(word)))
+		return false;
+	Shard* shard = getShardForUpdate(word.size());
+
+	std::vector<std::string_view>& bucket = getBucketForUpdate(shard, EnglishLetters::getLetterPattern(word));
+	for (unsigned int i = 0; i < bucket.size(); i++)
+	{
+		if (bucket[i] != word)
+			continue;
+		//the view in the bucket points at text the shard keeps, so it can stand for the word in changedWords
+		shard->changedWords.associate(bucket[i], false);
+		bucket[i] = bucket.back();
+		bucket.pop_back();
+		break;
+	}
+	shard->numWords--;
+	if (shard->changedWords.getNumItems() > MAX_CHANGED_WORDS)
+		mergeChanges(shard);
+	return true;
+}
+
+//O(D + C * B), D = size of the file, C = number of changes, B = words with a changed word's pattern.
+//a length shared with a copy of the list is copied once for the whole file, not once per word
+//one change per line: "+word" or "word" adds the word, "-word" removes it
+int WordListImpl::applyDelta(std::string filename, std::vector<std::string>* changedWords)
+{
+	std::ifstream infile(filename);
+	if (!infile)
+		return -1;
+	int numChanged = 0;
+	std::string line;
+	while (std::getline(infile, line))
+	{
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		if (line.empty())
+			continue;
+		bool isRemoval = line[0] == '-';
+		std::string word = (line[0] == '-' || line[0] == '+') ? line.substr(1) : line;
+		if (isRemoval ? !removeWord(word) : !addWord(word))
+			continue;
+		numChanged++;
+		if (changedWords != nullptr && normalizeWord(word))
+			changedWords->push_back(word);
+	}
+	return numChanged;
+}
+
+//O(W), W = words in the shard
+std::vector<std::string_view> WordListImpl::getLiveWords(const Shard* shard, std::vector<std::string_view>* patterns) const
+{
+	std::vector<std::string_view> words;
+	auto addBucket = [shard, patterns, &words](std::string_view pattern)
+	{
+		const std::string_view* bucket;
+		int numWords;
+		getBucket(shard, pattern, bucket, numWords);
+		words.insert(words.end(), bucket, bucket + numWords);
+		if (patterns != nullptr)
+			patterns->insert(patterns->end(), numWords, pattern);
+	};
+	//the tables' patterns in their order (with any changes to their words), then the patterns only added words have
+	for (unsigned int b = 0; b < shard->tables->bucketPatterns.size(); b++)
+		addBucket(shard->tables->bucketPatterns[b]);
+	shard->changedBuckets.forEach([shard, &addBucket](std::string_view pattern, const std::shared_ptr<std::vector<std::string_view>>&)
+	{
+		if (shard->tables->wordTable.find(pattern) == nullptr)
+			addBucket(pattern);
+	});
+	return words;
+}
+
+//O(1)
+void WordListImpl::getBucket(const Shard* shard, std::string_view pattern, const std::string_view*& words, int& numWords)
+{
+	//a changed pattern's list stands in for its bucket (the table is only looked in if there are any)
+	if (shard->changedBuckets.getNumItems() > 0)
+	{
+		const std::shared_ptr<std::vector<std::string_view>>* changed = shard->changedBuckets.find(pattern);
+		if (changed != nullptr)
 		{
-			//add it's pattern letter to the pattern string, save that we've seen this letter, increment int so next new letter gets next CAP letter
-			letterPatternToReturn += CAPLetters[nextCAPLetterToUseIndex];		
-			charsSeen.associate(word[i], CAPLetters[nextCAPLetterToUseIndex]);	
-			nextCAPLetterToUseIndex++;											
+			words = (*changed)->data();
+			numWords = static_cast<int>((*changed)->size());
+			return;
 		}
-		//if the letter has been seen already, which means its in charsSeen	
-		else							
-			//add the letter's pattern pairing to the pattern string
-			letterPatternToReturn += *(charsSeen.find(word[i]));				
 	}
-	//after building the string, return it
-	return letterPatternToReturn;	
+	const PatternBucket* bucket = shard->tables->wordTable.find(pattern);
+	words = (bucket == nullptr) ? nullptr : shard->tables->patternWords.data() + bucket->firstWord;
+	numWords = (bucket == nullptr) ? 0 : bucket->numWords;
+}
+
+//O(1)
+bool WordListImpl::hasWord(const Shard* shard, std::string_view word)
+{
+	if (shard->changedWords.getNumItems() > 0)
+	{
+		const bool* isInList = shard->changedWords.find(word);
+		if (isInList != nullptr)
+			return *isInList;
+	}
+	return shard->tables->hasAllWords.find(word) != nullptr;
 }
 
 //////////////////////////////////////////////////////////////////////////////
@@ -251,7 +963,37 @@ WordList::~WordList()
 
 bool WordList::loadWordList(std::string filename)
 {
-	return m_impl->loadWordList(filename);
+	return m_impl->loadWordList(filename, 0);
+}
+
+bool WordList::loadWordList(std::string filename, int numThreads)
+{
+	return m_impl->loadWordList(filename, numThreads);
+}
+
+bool WordList::saveCompiledWordList(std::string filename)
+{
+	return m_impl->saveCompiledWordList(filename);
+}
+
+void WordList::setLazyLoading(bool lazy)
+{
+	m_impl->setLazyLoading(lazy);
+}
+
+std::vector<WordListShardStats> WordList::getShardStats() const
+{
+	return m_impl->getShardStats();
+}
+
+void WordList::setTableStatsOutput(std::ostream* out)
+{
+	m_impl->setTableStatsOutput(out);
+}
+
+void WordList::printTableStats(std::ostream& out) const
+{
+	m_impl->printTableStats(out);
 }
 
 bool WordList::contains(std::string word) const
@@ -262,4 +1004,24 @@ bool WordList::contains(std::string word) const
 std::vector<std::string> WordList::findCandidates(std::string cipherWord, std::string currTranslation) const
 {
 	return m_impl->findCandidates(cipherWord, currTranslation);
-}
\ No newline at end of file
+}
+
+bool WordList::addWord(std::string word)
+{
+	return m_impl->addWord(word);
+}
+
+bool WordList::removeWord(std::string word)
+{
+	return m_impl->removeWord(word);
+}
+
+int WordList::applyDelta(std::string filename, std::vector<std::string>* changedWords)
+{
+	return m_impl->applyDelta(filename, changedWords);
+}
+
+void WordList::copyFrom(const WordList& other)
+{
+	m_impl->copyFrom(*other.m_impl);
+}
\ No newline at end of file
@@ -0,0 +1,197 @@
+#include "WorkloadGenerator.h"
+#include "Alphabet.h"
+#include "MyHash.h"
+#include <fstream>
+
+//splitmix64: tiny, fast, and the same sequence everywhere for the same seed
+class WorkloadRandom
+{
+public:
+	WorkloadRandom(unsigned long long seed) : m_state(seed) {}
+	unsigned long long next()
+	{
+		unsigned long long z = (m_state += 0x9E3779B97F4A7C15ull);
+		z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+		z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+		return z ^ (z >> 31);
+	}
+	//uniform in [0, n), throwing away the top of the range that would make small values more likely
+	unsigned long long nextBelow(unsigned long long n)
+	{
+		unsigned long long limit = ~0ull - (~0ull % n);
+		unsigned long long x;
+		do
+			x = next();
+		while (x >= limit);
+		return x % n;
+	}
+	//uniform in [0, 1)
+	double nextDouble() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+private:
+	unsigned long long m_state;
+};
+
+WorkloadGenerator::WorkloadGenerator()
+{}
+
+//O(W * L), W = number of words in file
+bool WorkloadGenerator::loadWordList(const std::string& filename)
+{
+	std::ifstream file(filename);
+	if (!file)
+		return false;
+	m_words.clear();
+	m_rareWords.clear();
+	m_ambiguousWords.clear();
+
+	//keep every word made of letters and apostrophes (lowercased), counting how many share each pattern
+	MyHash<std::string, int> numWordsWithPattern;
+	std::string line;
+	while (std::getline(file, line))
+	{
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		bool isGood = !line.empty();
+		for (unsigned int i = 0; i < line.size() && isGood; i++)
+		{
+			isGood = EnglishLetters::isWordCharacter(line[i]);
+			line[i] = EnglishLetters::toLower(line[i]);
+		}
+		if (!isGood)
+			continue;
+		(*numWordsWithPattern.emplace(EnglishLetters::getLetterPattern(line), 0))++;
+		m_words.push_back(line);
+	}
+
+	//then sort out the rare and ambiguous ones, keeping the file's order so results don't depend on the hash table
+	for (unsigned int w = 0; w < m_words.size(); w++)
+	{
+		int bucketSize = *numWordsWithPattern.find(EnglishLetters::getLetterPattern(m_words[w]));
+		if (bucketSize <= RARE_MAX_BUCKET_SIZE)
+			m_rareWords.push_back(m_words[w]);
+		else if (m_words[w].size() <= static_cast<unsigned int>(AMBIGUOUS_MAX_LENGTH) && bucketSize >= AMBIGUOUS_MIN_BUCKET_SIZE)
+			m_ambiguousWords.push_back(m_words[w]);
+	}
+	return !m_words.empty();
+}
+
+//O(N), N = size of file
+bool WorkloadGenerator::loadCorpus(const std::string& filename)
+{
+	std::ifstream file(filename);
+	if (!file)
+		return false;
+	m_sentences.clear();
+	std::string line;
+	while (std::getline(file, line))
+	{
+		if (!line.empty() && line.back() == '\r')
+			line.pop_back();
+		if (!line.empty())
+			m_sentences.push_back(line);
+	}
+	return !m_sentences.empty();
+}
+
+//O(M * N), M = number of messages, N = length of each (plus one pass over the corpus if there is one)
+bool WorkloadGenerator::generate(const WorkloadOptions& options, std::vector<std::string>& plaintexts, std::vector<std::string>& ciphertexts) const
+{
+	plaintexts.clear();
+	ciphertexts.clear();
+	//every message has at least one word, so there's something to capitalize
+	if (options.minWords < 1 || options.maxWords < options.minWords)
+		return false;
+
+	//with a corpus, only its sentences that fit the word count and length can be picked
+	std::vector<int> fittingSentences;
+	for (unsigned int s = 0; s < m_sentences.size(); s++)
+	{
+		int numWords = 0;
+		for (unsigned int i = 0; i < m_sentences[s].size(); i++)
+			if (m_sentences[s][i] != ' ' && (i == 0 || m_sentences[s][i - 1] == ' '))
+				numWords++;
+		if (numWords >= options.minWords && numWords <= options.maxWords
+			&& (options.maxLength <= 0 || m_sentences[s].size() <= static_cast<unsigned int>(options.maxLength)))
+			fittingSentences.push_back(s);
+	}
+	if (m_sentences.empty() ? m_words.empty() : fittingSentences.empty())
+		return false;
+
+	WorkloadRandom random(options.seed);
+	for (int m = 0; m < options.numMessages; m++)
+	{
+		std::string plaintext = m_sentences.empty() ? makeSentence(options, random)
+			: m_sentences[fittingSentences[random.nextBelow(fittingSentences.size())]];
+
+		//a fresh key for every message: shuffle the alphabet (Fisher-Yates), plain letter i becomes key[i]
+		char key[EnglishLetters::SIZE];
+		for (int i = 0; i < EnglishLetters::SIZE; i++)
+			key[i] = EnglishLetters::letter(i);
+		for (int i = EnglishLetters::SIZE - 1; i > 0; i--)
+		{
+			int j = static_cast<int>(random.nextBelow(i + 1));
+			char temp = key[i];
+			key[i] = key[j];
+			key[j] = temp;
+		}
+
+		//encrypt, keeping case and everything that isn't a letter
+		std::string ciphertext = plaintext;
+		for (unsigned int i = 0; i < ciphertext.size(); i++)
+		{
+			int plainIndex = EnglishLetters::indexOf(ciphertext[i]);
+			if (plainIndex != EnglishLetters::NOT_A_LETTER)
+				ciphertext[i] = EnglishLetters::isUpper(ciphertext[i]) ? EnglishLetters::toUpper(key[plainIndex]) : key[plainIndex];
+		}
+		plaintexts.push_back(plaintext);
+		ciphertexts.push_back(ciphertext);
+	}
+	return true;
+}
+
+//O(W), W = number of words in the sentence
+std::string WorkloadGenerator::makeSentence(const WorkloadOptions& options, WorkloadRandom& random) const
+{
+	int numWords = options.minWords;
+	if (options.maxWords > options.minWords)
+		numWords += static_cast<int>(random.nextBelow(options.maxWords - options.minWords + 1));
+
+	std::string sentence;
+	for (int w = 0; w < numWords; w++)
+	{
+		//decide which kind of word this is, then pick one of that kind (any word if there are none)
+		double kind = random.nextDouble();
+		const std::vector<std::string>* pool = &m_words;
+		if (kind < options.rareShare && !m_rareWords.empty())
+			pool = &m_rareWords;
+		else if (kind >= options.rareShare && kind < options.rareShare + options.ambiguousShare && !m_ambiguousWords.empty())
+			pool = &m_ambiguousWords;
+		const std::string& word = (*pool)[random.nextBelow(pool->size())];
+
+		//stop once the next word (and the period) wouldn't fit, but always keep at least one
+		std::size_t newLength = sentence.size() + (sentence.empty() ? 0 : 1) + word.size() + 1;
+		if (!sentence.empty() && options.maxLength > 0 && newLength > static_cast<std::size_t>(options.maxLength))
+			break;
+		if (!sentence.empty())
+			sentence += ' ';
+		sentence += word;
+	}
+	//written like a sentence: capitalized, with a period
+	sentence[0] = EnglishLetters::toUpper(sentence[0]);
+	return sentence + '.';
+}
+
+//O(M * N)
+bool WorkloadGenerator::writeWorkload(const std::string& prefix, const std::vector<std::string>& plaintexts, const std::vector<std::string>& ciphertexts)
+{
+	std::ofstream cipherFile(prefix + ".cipher.txt");
+	std::ofstream plainFile(prefix + ".plain.txt");
+	if (!cipherFile || !plainFile)
+		return false;
+	for (unsigned int m = 0; m < ciphertexts.size(); m++)
+	{
+		cipherFile << ciphertexts[m] << '\n';
+		plainFile << plaintexts[m] << '\n';
+	}
+	return static_cast<bool>(cipherFile) && static_cast<bool>(plainFile);
+}
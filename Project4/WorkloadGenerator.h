@@ -0,0 +1,57 @@
+#ifndef WORKLOADGENERATOR_INCLUDED
+#define WORKLOADGENERATOR_INCLUDED
+
+#include <string>
+#include <vector>
+
+class WorkloadRandom;
+
+//what kind of messages WorkloadGenerator makes
+struct WorkloadOptions
+{
+	//the same seed (and word list or corpus) always gives the same messages, on any machine
+	unsigned long long seed = 1;
+	int numMessages = 100;
+	int minWords = 3;
+	int maxWords = 10;
+	//most characters a message can have (0 for no limit). words stop being added once the next would pass it
+	int maxLength = 0;
+	//chance that each word is rare: one of at most RARE_MAX_BUCKET_SIZE words with its letter pattern,
+	//which makes a message easier since the word has few candidates
+	double rareShare = 0;
+	//chance that each word is ambiguous: a short word whose pattern is shared by at least
+	//AMBIGUOUS_MIN_BUCKET_SIZE words, which makes a message harder
+	double ambiguousShare = 0;
+};
+
+//makes reproducible test messages: plaintext sentences built from a word list (or taken from a corpus
+//of sentences), each encrypted with its own random key. it draws from its own random number generator
+//instead of <random>'s distributions, whose results differ between standard libraries
+class WorkloadGenerator
+{
+public:
+	WorkloadGenerator();
+	//words with anything other than letters and apostrophes are skipped
+	bool loadWordList(const std::string& filename);
+	//one sentence per line. once a corpus is loaded, messages are its sentences (rareShare and
+	//ambiguousShare don't apply), picked at random among those that fit the word count and length
+	bool loadCorpus(const std::string& filename);
+	//plaintexts[i] is what ciphertexts[i] decrypts to. returns false if there's nothing to build messages from,
+	//or if minWords is under 1 or maxWords is under minWords
+	bool generate(const WorkloadOptions& options, std::vector<std::string>& plaintexts, std::vector<std::string>& ciphertexts) const;
+	//writes prefix.cipher.txt and prefix.plain.txt, one message per line in the same order
+	static bool writeWorkload(const std::string& prefix, const std::vector<std::string>& plaintexts, const std::vector<std::string>& ciphertexts);
+private:
+	static const int RARE_MAX_BUCKET_SIZE = 2;
+	static const int AMBIGUOUS_MAX_LENGTH = 4;
+	static const int AMBIGUOUS_MIN_BUCKET_SIZE = 100;
+
+	std::vector<std::string> m_words;
+	std::vector<std::string> m_rareWords;
+	std::vector<std::string> m_ambiguousWords;
+	std::vector<std::string> m_sentences;
+
+	std::string makeSentence(const WorkloadOptions& options, WorkloadRandom& random) const;
+};
+
+#endif // WORKLOADGENERATOR_INCLUDED
@@ -1,8 +1,296 @@
 #include "provided.h"
 #include "MyHash.h"
+#include "Alphabet.h"
+#include "ConcurrentHash.h"
+#include "DecryptServer.h"
+#include "WorkloadGenerator.h"
+#include "BulkTranslator.h"
+#include "MappedFile.h"
+#include "BatchRunner.h"
+#include <algorithm>
 #include <iostream>
+#include <fstream>
+#include <string>
 #include <vector>
 #include <cassert>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <cstdlib>
+#include <new>
+
+//define COUNT_ALLOCATIONS to count every heap allocation the program makes (used by test 13)
+#ifdef COUNT_ALLOCATIONS
+std::atomic<long long> g_numAllocations(0);
+void* operator new(std::size_t size)
+{
+	g_numAllocations++;
+	if (void* p = std::malloc(size == 0 ? 1 : size))
+		return p;
+	throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+#endif
+
+//runs the mode named on the command line instead of the tests below:
+//	Project4 --serve <address> [wordlist] [workers]
+//		keeps the dictionary loaded and answers crack requests at address (see DecryptServer.h)
+//	Project4 --load <address> <messagesFile> [requests] [connections] [deadlineMs] [maxSolutions]
+//		sends requests for the messages in messagesFile (one per line) and reports latency and throughput
+//	Project4 --generate <outPrefix> [seed=N] [count=N] [minWords=N] [maxWords=N] [maxLength=N] [rare=0..1] [ambiguous=0..1] [wordlist=file | corpus=file]
+//		writes a seeded set of messages to outPrefix.cipher.txt and their plaintexts to outPrefix.plain.txt (see WorkloadGenerator.h)
+//	Project4 --crack-keys <file> [prefixBytes] [wordlist]
+//		solves the key from the first prefixBytes of file (64 KB by default) and prints each key that fits
+//	Project4 --translate <key> <inFile> <outFile>
+//		applies key to the whole of inFile, writing the result to outFile (see BulkTranslator.h)
+//	Project4 --explain-plan <ciphertext> [wordlist]
+//		prints the search plan for ciphertext: which word each step tries and the words it checks
+//	Project4 --estimate <messagesFile> [wordlist] [deadlineMs]
+//		cracks each message in messagesFile and compares the estimated search nodes against the real ones
+//	Project4 --batch <messagesFile> <outFile> [wordlist] [workers] [spoolDir] [deadlineMs]
+//		cracks every message in messagesFile on worker processes, writing the results to outFile in order (see BatchRunner.h)
+int runCommandLine(int argc, char* argv[])
+{
+	std::string mode = argv[1];
+	if (mode == "--serve" && argc >= 3)
+	{
+		Decrypter d;
+		if (!d.load(argc > 3 ? argv[3] : "wordlist.txt"))
+		{
+			std::cout << "Dictionary failed to load" << std::endl;
+			return 1;
+		}
+		int numWorkers = argc > 4 ? atoi(argv[4]) : static_cast<int>(std::thread::hardware_concurrency());
+		DecryptServer server(d, numWorkers);
+		if (!server.listen(argv[2]))
+		{
+			std::cout << "Can't listen at " << argv[2] << std::endl;
+			return 1;
+		}
+		std::cout << "Serving at " << argv[2] << std::endl;
+		server.run();
+		return 0;
+	}
+	if (mode == "--load" && argc >= 4)
+	{
+		std::ifstream messagesFile(argv[3]);
+		std::vector<std::string> messages;
+		for (std::string line; std::getline(messagesFile, line); )
+			if (!line.empty())
+				messages.push_back(line);
+		CrackOptions options;
+		options.deadlineInMilliseconds = argc > 6 ? atoi(argv[6]) : 0;
+		options.maxSolutions = argc > 7 ? atoi(argv[7]) : 0;
+		LoadReport report;
+		if (!runLoadGenerator(argv[2], messages, argc > 4 ? atoi(argv[4]) : 100, argc > 5 ? atoi(argv[5]) : 4, options, report))
+		{
+			std::cout << "Can't connect to " << argv[2] << " (or no messages in " << argv[3] << ")" << std::endl;
+			return 1;
+		}
+		std::cout << report.numRequests << " requests in " << report.seconds << " s: " << report.requestsPerSecond << " per second, p50 "
+			<< report.p50Milliseconds << " ms, p99 " << report.p99Milliseconds << " ms, " << report.numTimedOut << " timed out, "
+			<< report.numFailed << " failed, " << report.numConnectionsLost << " connections lost" << std::endl;
+		return report.numFailed == 0 ? 0 : 1;
+	}
+	if (mode == "--generate" && argc >= 3)
+	{
+		//the rest are key=value pairs, e.g. seed=7 count=500 rare=0.2
+		WorkloadOptions options;
+		std::string wordListFile = "wordlist.txt";
+		std::string corpusFile;
+		for (int i = 3; i < argc; i++)
+		{
+			std::string arg = argv[i];
+			std::size_t equals = arg.find('=');
+			std::string name = arg.substr(0, equals);
+			std::string value = equals == std::string::npos ? "" : arg.substr(equals + 1);
+			if (name == "seed")
+				options.seed = std::strtoull(value.c_str(), nullptr, 10);
+			else if (name == "count")
+				options.numMessages = atoi(value.c_str());
+			else if (name == "minWords")
+				options.minWords = atoi(value.c_str());
+			else if (name == "maxWords")
+				options.maxWords = atoi(value.c_str());
+			else if (name == "maxLength")
+				options.maxLength = atoi(value.c_str());
+			else if (name == "rare")
+				options.rareShare = atof(value.c_str());
+			else if (name == "ambiguous")
+				options.ambiguousShare = atof(value.c_str());
+			else if (name == "wordlist")
+				wordListFile = value;
+			else if (name == "corpus")
+				corpusFile = value;
+			else
+			{
+				std::cout << "Unknown option " << arg << std::endl;
+				return 1;
+			}
+		}
+		WorkloadGenerator generator;
+		if (corpusFile.empty() ? !generator.loadWordList(wordListFile) : !generator.loadCorpus(corpusFile))
+		{
+			std::cout << "Can't load " << (corpusFile.empty() ? wordListFile : corpusFile) << std::endl;
+			return 1;
+		}
+		std::vector<std::string> plaintexts;
+		std::vector<std::string> ciphertexts;
+		if (!generator.generate(options, plaintexts, ciphertexts))
+		{
+			std::cout << "Nothing fits those options" << std::endl;
+			return 1;
+		}
+		if (!WorkloadGenerator::writeWorkload(argv[2], plaintexts, ciphertexts))
+		{
+			std::cout << "Can't write " << argv[2] << ".cipher.txt or " << argv[2] << ".plain.txt" << std::endl;
+			return 1;
+		}
+		std::cout << "Wrote " << ciphertexts.size() << " messages to " << argv[2] << ".cipher.txt and " << argv[2] << ".plain.txt" << std::endl;
+		return 0;
+	}
+	if (mode == "--crack-keys" && argc >= 3)
+	{
+		//solve the key from the start of the file only, cut back to the last space so no word is split
+		MappedFile file;
+		if (!file.open(argv[2]))
+		{
+			std::cout << "Can't open " << argv[2] << std::endl;
+			return 1;
+		}
+		std::size_t prefixSize = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 64 * 1024;
+		if (prefixSize < file.size())
+		{
+			while (prefixSize > 0 && file.data()[prefixSize] != ' ' && file.data()[prefixSize] != '\n')
+				prefixSize--;
+		}
+		else
+			prefixSize = file.size();
+		Decrypter d;
+		if (!d.load(argc > 4 ? argv[4] : "wordlist.txt"))
+		{
+			std::cout << "Dictionary failed to load" << std::endl;
+			return 1;
+		}
+		CrackOptions options;
+		options.sampleWords = 16;
+		//crack only splits words at spaces and punctuation, so line breaks and tabs become spaces
+		std::string prefix(file.data(), prefixSize);
+		for (unsigned int i = 0; i < prefix.size(); i++)
+			if (prefix[i] == '\n' || prefix[i] == '\r' || prefix[i] == '\t')
+				prefix[i] = ' ';
+		CrackKeysResult result = d.crackKeys(prefix, options);
+		for (unsigned int k = 0; k < result.keys.size(); k++)
+			std::cout << result.keys[k] << std::endl;
+		return result.keys.empty() ? 1 : 0;
+	}
+	if (mode == "--translate" && argc >= 5)
+	{
+		BulkTranslator translator;
+		if (!translator.setKey(argv[2]))
+		{
+			std::cout << "Not a key: " << argv[2] << std::endl;
+			return 1;
+		}
+		if (!translator.translateFile(argv[3], argv[4]))
+		{
+			std::cout << "Can't translate " << argv[3] << " into " << argv[4] << std::endl;
+			return 1;
+		}
+		return 0;
+	}
+	if (mode == "--explain-plan" && argc >= 3)
+	{
+		Decrypter d;
+		if (!d.load(argc > 3 ? argv[3] : "wordlist.txt"))
+		{
+			std::cout << "Dictionary failed to load" << std::endl;
+			return 1;
+		}
+		d.explainPlan(argv[2], std::cout);
+		return 0;
+	}
+	if (mode == "--estimate" && argc >= 3)
+	{
+		//predicted against actual nodes for each message, to see how far the estimate can be trusted
+		std::ifstream messagesFile(argv[2]);
+		Decrypter d;
+		if (!messagesFile || !d.load(argc > 3 ? argv[3] : "wordlist.txt"))
+		{
+			std::cout << "Can't open " << argv[2] << " or load the dictionary" << std::endl;
+			return 1;
+		}
+		CrackOptions options;
+		options.deadlineInMilliseconds = argc > 4 ? atoi(argv[4]) : 10000;
+		std::vector<double> errorFactors;
+		int numTimedOut = 0;
+		for (std::string line; std::getline(messagesFile, line); )
+		{
+			if (line.empty())
+				continue;
+			CrackCostEstimate estimate = d.estimateCost(line);
+			CrackResult result = d.crack(line, options);
+			if (result.fromCache)
+				continue;
+			double actual = static_cast<double>(std::max(1LL, result.searchNodes));
+			double predicted = std::max(1.0, estimate.searchNodes);
+			std::cout << predicted << " predicted, " << result.searchNodes << (result.timedOut ? "+" : "") << " actual: " << line << std::endl;
+			//a search cut off by the deadline only gives a lower bound, so it's left out of the summary
+			if (result.timedOut)
+				numTimedOut++;
+			else
+				errorFactors.push_back(predicted > actual ? predicted / actual : actual / predicted);
+		}
+		if (errorFactors.empty())
+			return 1;
+		std::sort(errorFactors.begin(), errorFactors.end());
+		int numWithin10 = 0;
+		for (unsigned int i = 0; i < errorFactors.size(); i++)
+			if (errorFactors[i] <= 10)
+				numWithin10++;
+		std::cout << errorFactors.size() << " messages (" << numTimedOut << " more timed out): median off by " << errorFactors[errorFactors.size() / 2]
+			<< "x, 90th percentile by " << errorFactors[errorFactors.size() * 9 / 10] << "x, " << numWithin10 << " within 10x" << std::endl;
+		return 0;
+	}
+	if (mode == "--batch" && argc >= 4)
+	{
+		//the workers share what's loaded here, so a compiled list is best (see BatchRunner.h)
+		Decrypter d;
+		if (!d.load(argc > 4 ? argv[4] : "wordlist.txt"))
+		{
+			std::cout << "Dictionary failed to load" << std::endl;
+			return 1;
+		}
+		BatchOptions options;
+		options.numWorkers = argc > 5 ? atoi(argv[5]) : static_cast<int>(std::thread::hardware_concurrency());
+		if (argc > 6)
+			options.spoolDirectory = argv[6];
+		options.crackOptions.deadlineInMilliseconds = argc > 7 ? atoi(argv[7]) : 0;
+		BatchRunner runner(d, options);
+		BatchReport report;
+		if (!runner.run(argv[2], argv[3], report))
+		{
+			std::cout << "Can't read " << argv[2] << " or write " << argv[3] << " and " << options.spoolDirectory << std::endl;
+			return 1;
+		}
+		std::cout << report.numMessages << " messages in " << report.numShards << " shards, " << report.seconds << " s: "
+			<< report.numWorkersStarted << " workers started, " << report.numRetries << " retries, " << report.numFailedShards
+			<< " shards failed" << std::endl;
+		return report.numFailedShards == 0 ? 0 : 1;
+	}
+	std::cout << "usage: " << argv[0] << " --serve <address> [wordlist] [workers]" << std::endl;
+	std::cout << "       " << argv[0] << " --load <address> <messagesFile> [requests] [connections] [deadlineMs] [maxSolutions]" << std::endl;
+	std::cout << "       " << argv[0] << " --generate <outPrefix> [seed=N] [count=N] [minWords=N] [maxWords=N] [maxLength=N]" << std::endl;
+	std::cout << "                    [rare=0..1] [ambiguous=0..1] [wordlist=file | corpus=file]" << std::endl;
+	std::cout << "       " << argv[0] << " --crack-keys <file> [prefixBytes] [wordlist]" << std::endl;
+	std::cout << "       " << argv[0] << " --translate <key> <inFile> <outFile>" << std::endl;
+	std::cout << "       " << argv[0] << " --explain-plan <ciphertext> [wordlist]" << std::endl;
+	std::cout << "       " << argv[0] << " --estimate <messagesFile> [wordlist] [deadlineMs]" << std::endl;
+	std::cout << "       " << argv[0] << " --batch <messagesFile> <outFile> [wordlist] [workers] [spoolDir] [deadlineMs]" << std::endl;
+	return 1;
+}
 
 //Sanity Tests Passed:
 //	MyHash
@@ -11,8 +299,11 @@
 //	Translator
 //	Decrypter
 
-int main()														//EACH ON OF THESE ARE SAVED ON G32
+int main(int argc, char* argv[])									//EACH ON OF THESE ARE SAVED ON G32
 {
+	if (argc > 1)
+		return runCommandLine(argc, argv);
+
 	// MyHash Tests ////////////////
 	/* new array												1 WORKS ON BOTH COMPILERS
 	MyHash<std::string, int> hm1(.01);
@@ -61,13 +352,12 @@ int main()														//EACH ON OF THESE ARE SAVED ON G32
 
 	// Wordlist Tests ///////////////
 	/*	tests getLetterPattern()								5 WORKS ON BOTH COMPILERS
-	WordListImpl w1;
-	std::cout << ": " << w1.getLetterPattern("") << std::endl;
-	std::cout << "asdf: " << w1.getLetterPattern("asdf") << std::endl;
-	std::cout << "aAbBcC: " << w1.getLetterPattern("aAbBcC") << std::endl;
-	std::cout << "Happy: " << w1.getLetterPattern("Happy") << std::endl;
-	std::cout << "testsssssss: " << w1.getLetterPattern("testsssssss") << std::endl;
-	std::cout << "qazwsxedcrfvtgbyhnujmikolpplokimjunhybgtvfrcdexswzaq: " << w1.getLetterPattern("qazwsxedcrfvtgbyhnujmikolpplokimjunhybgtvfrcdexswzaq") << std::endl;
+	std::cout << ": " << EnglishLetters::getLetterPattern("") << std::endl;
+	std::cout << "asdf: " << EnglishLetters::getLetterPattern("asdf") << std::endl;
+	std::cout << "aAbBcC: " << EnglishLetters::getLetterPattern("aAbBcC") << std::endl;
+	std::cout << "Happy: " << EnglishLetters::getLetterPattern("Happy") << std::endl;
+	std::cout << "testsssssss: " << EnglishLetters::getLetterPattern("testsssssss") << std::endl;
+	std::cout << "qazwsxedcrfvtgbyhnujmikolpplokimjunhybgtvfrcdexswzaq: " << EnglishLetters::getLetterPattern("qazwsxedcrfvtgbyhnujmikolpplokimjunhybgtvfrcdexswzaq") << std::endl;
 	*/
 
 	/*	tests loadWordList(), contains()						6 WORKS ON BOTH COMPILERS
@@ -142,6 +432,88 @@ int main()														//EACH ON OF THESE ARE SAVED ON G32
 	*/
 	//11 tested shift to privided.h
 
+	/*	times loadWordList() against thread count				12
+	for (int threads = 1; threads <= (int)std::thread::hardware_concurrency() * 2; threads *= 2)
+	{
+		WordList w4;
+		auto start = std::chrono::steady_clock::now();
+		w4.loadWordList("wordlist.txt", threads);
+		auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+		std::cout << threads << " threads: " << ms << " ms" << std::endl;
+	}
+	*/
+
+	/*	counts heap allocations per word in loadWordList() (build with COUNT_ALLOCATIONS)		13
+	WordList w5;
+	long long allocationsBefore = g_numAllocations;
+	w5.loadWordList("wordlist.txt", 1);
+	std::cout << (g_numAllocations - allocationsBefore) / 109647.0 << " allocations per word" << std::endl; // ~0.001 (was ~9.8)
+	*/
+
+	/*	tests saveCompiledWordList(), lazy loading and getShardStats()		14
+	WordList w6;
+	w6.loadWordList("wordlist.txt");
+	w6.saveCompiledWordList("wordlist.p4d");
+	WordList w7;
+	w7.setLazyLoading(true);
+	w7.loadWordList("wordlist.p4d");
+	std::cout << "'grotto' is in list: " << w7.contains("grotto") << std::endl;
+	for (const WordListShardStats& st : w7.getShardStats())
+		std::cout << "length " << st.wordLength << ": " << (st.isResident ? "resident, " : "not loaded, ") << st.numWords << " words, "
+			<< st.numLoads << " loads, " << st.numLookups << " lookups" << std::endl; // only length 6 is resident
+	*/
+
+	/*	ConcurrentHash vs one MyHash behind a single mutex, 1 to 32 threads and mixed read/write ratios		16
+	const int NUM_KEYS = 100000, OPS_PER_THREAD = 200000;
+	for (int readPercent : { 50, 90, 99 })
+	{
+		for (int numThreads = 1; numThreads <= 32; numThreads *= 2)
+		{
+			ConcurrentHash<int, int> striped;
+			MyHash<int, int> single;
+			std::mutex singleMutex;
+			for (int k = 0; k < NUM_KEYS; k += 2)
+			{
+				striped.associate(k, k);
+				single.associate(k, k);
+			}
+			double seconds[2];
+			for (int which = 0; which < 2; which++)
+			{
+				std::atomic<long long> numFound(0);
+				std::vector<std::thread> threads;
+				auto start = std::chrono::steady_clock::now();
+				for (int t = 0; t < numThreads; t++)
+					threads.emplace_back([&, t]
+					{
+						unsigned int x = 2463534242u + t;	//xorshift, so every thread does the same work each run
+						long long found = 0;
+						for (int op = 0; op < OPS_PER_THREAD; op++)
+						{
+							x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+							int key = x % NUM_KEYS, value;
+							bool isRead = (x >> 8) % 100 < static_cast<unsigned int>(readPercent);
+							if (which == 0)
+								found += isRead ? striped.find(key, value) : (striped.findOrInsert(key, op), 1);
+							else
+							{
+								std::lock_guard<std::mutex> lock(singleMutex);
+								found += isRead ? single.find(key) != nullptr : (single.emplace(key, op), 1);
+							}
+						}
+						numFound += found;
+					});
+				for (std::thread& th : threads)
+					th.join();
+				seconds[which] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			}
+			std::cout << readPercent << "% reads, " << numThreads << " threads: striped "
+				<< numThreads * OPS_PER_THREAD / seconds[0] / 1e6 << " Mops/s, one mutex "
+				<< numThreads * OPS_PER_THREAD / seconds[1] / 1e6 << " Mops/s" << std::endl;
+		}
+	}
+	*/
+
 // Decrypter Tests ///////////////							FINAL WORKS ON BOTH COMPILERS
 	Decrypter d;
 	if (!d.load("wordlist.txt"))
@@ -152,6 +524,258 @@ int main()														//EACH ON OF THESE ARE SAVED ON G32
 
 	std::vector<std::string> v;
 
+	/*	tests the crack() result cache with a relabeled message		15
+	v = d.crack("y qook ra bdttook yqkook");
+	v = d.crack("z prrl sb ceuurrl zplrrl");	//same message, every cipher letter shifted
+	CrackCacheStats cs = d.getCacheStats();
+	std::cout << "hits: " << cs.hits << " misses: " << cs.misses << " entries: " << cs.numEntries << std::endl; // 1 1 1
+	*/
+
+	/*	tests crack() with options, and how often the candidate lists were already filtered		17
+	CrackOptions opts;
+	opts.maxSolutions = 100;
+	CrackResult r = d.crack("Hrux wbrxl brix pn paaec; wagrh wbrxl brix p qpnpnp.", opts);
+	std::cout << r.solutions.size() << " solutions" << (r.hitSolutionLimit ? " (limit hit)" : "") << ", candidate lists: "
+		<< r.candidateListHits << " hits out of " << r.candidateListLookups << std::endl;	// 100 solutions (limit hit)
+	*/
+
+	/*	tests that a generated workload cracks back to its own plaintexts		18
+	WorkloadGenerator gen;
+	gen.loadWordList("wordlist.txt");
+	WorkloadOptions wopts;
+	wopts.seed = 7;
+	wopts.numMessages = 10;
+	wopts.rareShare = 0.3;
+	std::vector<std::string> plains, ciphers;
+	gen.generate(wopts, plains, ciphers);
+	for (unsigned int i = 0; i < ciphers.size(); i++)
+	{
+		std::vector<std::string> sols = d.crack(ciphers[i]);
+		bool found = false;
+		for (unsigned int j = 0; j < sols.size(); j++)
+			found = found || sols[j] == plains[i];
+		std::cout << (found ? "found: " : "MISSING: ") << plains[i] << std::endl;
+	}
+	*/
+
+	/*	tests the hash table stats, printed for the word list's tables after load and again after a crack		19
+	Decrypter d2;
+	d2.setTableStatsOutput(&std::cout);
+	d2.load("wordlist.txt");
+	d2.crack("Xjzwq gjz cuvq xz huri arwqvudiy fr xrwdxrwqvu!");
+	d2.printTableStats(std::cout);
+	*/
+
+	/*	tests crackJoint() on three messages sharing a key (alone, the last one has 1090 solutions)		20
+	std::vector<std::string> msgs = { "Eiosrktf ligxsr hsqn gxzlort.", "Ukqrxqzt lzxrtfzl vkozt zitltl.", "Fgwgrn tbhteztr ziol." };
+	JointCrackResult jr = d.crackJoint(msgs);
+	for (unsigned int i = 0; i < jr.solutions.size(); i++)
+	{
+		std::cout << jr.solutions[i].key << std::endl;		// ?x??cnoph?rs?yi?adlegwbu?t
+		for (unsigned int m = 0; m < jr.solutions[i].plaintexts.size(); m++)
+			std::cout << "  " << jr.solutions[i].plaintexts[m] << std::endl;
+	}
+	*/
+
+	/*	tests crack() with a crib that could be any word: 79632 solutions instead of about 20 million		21
+	CrackOptions hints;
+	hints.cribs.push_back(CrackCrib{ "the", -1 });
+	CrackResult hr = d.crack("Zit eqz lqz gf q dqz.", hints);
+	std::cout << hr.solutions.size() << " solutions" << std::endl;
+	hints.cribs[0].position = 0;
+	hints.fixedKey = "????????????????a?????????";	//q is a
+	hr = d.crack("Zit eqz lqz gf q dqz.", hints);
+	std::cout << hr.solutions.size() << " solutions" << std::endl;	// 34920 solutions
+	*/
+
+	/*	tests solving a long message from a sample of its words (800 generated sentences, about 50 KB)		22
+	WorkloadGenerator longGen;
+	longGen.loadWordList("wordlist.txt");
+	WorkloadOptions longOpts;
+	longOpts.seed = 5;
+	longOpts.numMessages = 800;
+	std::vector<std::string> sentences, unused;
+	longGen.generate(longOpts, sentences, unused);
+	std::string doc;
+	for (unsigned int i = 0; i < sentences.size(); i++)
+		doc += sentences[i] + " ";
+	for (unsigned int i = 0; i < doc.size(); i++)	//shift every letter by one
+	{
+		if (doc[i] == 'z' || doc[i] == 'Z')
+			doc[i] -= 25;
+		else if ((doc[i] >= 'a' && doc[i] < 'z') || (doc[i] >= 'A' && doc[i] < 'Z'))
+			doc[i]++;
+	}
+	CrackOptions sampled;
+	sampled.sampleWords = 16;
+	auto sampleStart = std::chrono::steady_clock::now();
+	CrackResult sr = d.crack(doc, sampled);
+	std::cout << sr.solutions.size() << " solution(s) from " << sr.sampledWords << " words in "		// 1 solution(s) from 16 words
+		<< std::chrono::duration<double>(std::chrono::steady_clock::now() - sampleStart).count() << " s" << std::endl;
+	*/
+
+	/*	tests crackKeys(), then translating with the key it found		23
+	std::string quote = "Trcy oyc koon oz rweelycbb vmobcb, wyogrcn oecyb; hjg ozgcy tc moox bo moya wg grc vmobck koon grwg tc ko yog bcc grc oyc trlvr rwb hccy oecyck zon jb.";
+	CrackKeysResult kr = d.crackKeys(quote);
+	std::cout << kr.keys.size() << " key(s)" << std::endl;		// 2 key(s)
+	BulkTranslator bt;
+	if (!kr.keys.empty() && bt.setKey(kr.keys[0]))
+	{
+		bt.translate(quote.data(), quote.size(), &quote[0]);
+		std::cout << quote << std::endl;	// When one door of happiness closes, ...
+	}
+	*/
+
+	/*	tests anytime cracking: out of node budget with no solution, so the best partial decryption comes back		24
+	CrackOptions anytime;
+	anytime.anytime = true;
+	anytime.maxSearchNodes = 5;
+	CrackResult ar = d.crack("Mgkwsqb lqor ziqz vitf gft rggk gy iqhhoftll esgltl, qfgzitk ghtfl; wxz gyztf vt sgga lg sgfu qz zit esgltr rggk ziqz vt rg fgz ltt zit gft vioei iql wttf ghtftr ygk xl.", anytime);
+	std::cout << (ar.isPartial ? "partial: " : "") << ar.partialScore << std::endl;	// partial: 0.0882353
+	for (unsigned int i = 0; i < ar.solutions.size(); i++)
+		std::cout << ar.solutions[i] << std::endl;
+	*/
+
+	/*	tests the miss budget: a name that isn't in the word list fails the crack, unless one word may miss		25
+	CrackOptions misses;
+	std::cout << d.crack("Mgkwsqb voss dttz zit eqhzqof qz zit iqkwgk zgfouiz", misses).solutions.size() << std::endl;	// 0
+	misses.maxMissedWords = 1;
+	CrackResult mr = d.crack("Mgkwsqb voss dttz zit eqhzqof qz zit iqkwgk zgfouiz", misses);
+	for (unsigned int i = 0; i < mr.solutions.size(); i++)
+		std::cout << mr.solutions[i] << std::endl;		// ... ?orbla? will meet the captain at the harbor tonight ...
+	*/
+
+	/*	tests the portfolio: every word order races on its own thread, and the winner is logged		26
+	d.setPortfolioLog(&std::cout);
+	CrackOptions portfolio;
+	portfolio.portfolio = true;
+	CrackResult pr = d.crack("Xjzwq gjz cuvq xz huri arwqvudiy fuk ufjrqoq svquxiy. -Lzjk Nqkkqcy", portfolio);	// portfolio: ... won in ... us (1 wins)
+	std::cout << pr.solutions.size() << " solutions" << std::endl;
+	std::vector<CrackPortfolioStats> ps = d.getPortfolioStats();
+	for (unsigned int i = 0; i < ps.size(); i++)
+		std::cout << static_cast<int>(ps[i].wordOrder) << ": " << ps[i].wins << " wins, " << ps[i].winMicroseconds << " us" << std::endl;
+	d.setPortfolioLog(nullptr);
+	*/
+
+	/*	tests the search plan: which word each step tries, the letters it adds, and the words it checks		27
+	d.explainPlan("Xjzwq gjz cuvq xz huri arwqvudiy fuk ufjrqoq svquxiy. -Lzjk Nqkkqcy", std::cout);	// 11 distinct words, 7 steps ...
+	CrackOptions planOptions;
+	planOptions.wordOrder = CrackWordOrder::FewestCandidates;
+	d.explainPlan("Xjzwq gjz cuvq xz huri arwqvudiy fuk ufjrqoq svquxiy. -Lzjk Nqkkqcy", std::cout, planOptions);	// no plan: ...
+	*/
+
+	/*	tests the cost estimate against the nodes the search really takes		28
+	CrackCostEstimate ce = d.estimateCost("Xjzwq gjz cuvq xz huri arwqvudiy fuk ufjrqoq svquxiy. -Lzjk Nqkkqcy");
+	std::cout << ce.numCipherLetters << " letters, " << ce.numDistinctWords << " words, " << ce.numSteps << " steps" << std::endl;	// 21 letters, 11 words, 7 steps
+	CrackResult cr = d.crack("Xjzwq gjz cuvq xz huri arwqvudiy fuk ufjrqoq svquxiy. -Lzjk Nqkkqcy", CrackOptions());
+	std::cout << ce.searchNodes << " predicted, " << cr.searchNodes << " actual" << std::endl;	// 733302 predicted, 204625 actual
+	*/
+
+	/*	tests changing the dictionary in place: a name becomes a word, and only the results it could change leave the cache		29
+	std::cout << d.crack("Mgkwsqb voss dttz zit eqhzqof qz zit iqkwgk zgfouiz").size() << std::endl;	// 0
+	d.crack("Hrux wbrxl brix pn paaec; wagrh wbrxl brix p qpnpnp.");
+	std::cout << d.addWord("Zorblax") << d.addWord("zorblax") << std::endl;	// 10
+	std::cout << d.crack("Mgkwsqb voss dttz zit eqhzqof qz zit iqkwgk zgfouiz").size() << std::endl;	// 12
+	std::cout << d.crack("Hrux wbrxl brix pn paaec; wagrh wbrxl brix p qpnpnp.", CrackOptions()).fromCache << std::endl;	// 1
+	std::cout << d.removeWord("zorblax") << d.crack("Mgkwsqb voss dttz zit eqhzqof qz zit iqkwgk zgfouiz").size() << std::endl;	// 10
+	*/
+
+	/*	tests reloading while cracks run: they never pause or see half a word list, and the ones after the swap use the new list		30
+	{
+		std::ofstream newList("wordlist2.txt");
+		newList << std::ifstream("wordlist.txt").rdbuf() << "\nzorblax\n";
+	}
+	std::atomic<bool> isReloaded(false);
+	std::atomic<int> numOdd(0);
+	std::thread cracker([&]()
+	{
+		while (!isReloaded)
+		{
+			std::size_t n = d.crack("Mgkwsqb voss dttz zit eqhzqof qz zit iqkwgk zgfouiz").size();
+			if (n != 0 && n != 12)
+				numOdd++;
+		}
+	});
+	std::cout << d.load("wordlist2.txt") << d.load("no such list.txt") << std::endl;	// 10
+	isReloaded = true;
+	cracker.join();
+	std::cout << numOdd << " " << d.crack("Mgkwsqb voss dttz zit eqhzqof qz zit iqkwgk zgfouiz").size() << std::endl;	// 0 12
+	*/
+
+	/*	tests the batch runner: forked workers crack shards from the spool directory, and the results come back in input order		31
+	{
+		std::ofstream batchInput("batch.txt");
+		batchInput << "Hrux wbrxl brix pn paaec; wagrh wbrxl brix p qpnpnp.\n\nXjzwq gjz cuvq xz huri arwqvudiy fuk ufjrqoq svquxiy. -Lzjk Nqkkqcy\n"
+			<< "Mgkwsqb voss dttz zit eqhzqof qz zit iqkwgk zgfouiz\n";
+	}
+	BatchOptions batchOptions;
+	batchOptions.numWorkers = 2;
+	batchOptions.messagesPerShard = 1;
+	BatchRunner runner(d, batchOptions);
+	BatchReport report;
+	std::cout << runner.run("batch.txt", "batch.out.txt", report) << " " << report.numMessages << " " << report.numShards << " " << report.numFailedShards << std::endl;	// 1 3 3 0
+	std::ifstream batchOutput("batch.out.txt");
+	for (std::string line; std::getline(batchOutput, line); )
+		if (line.find(" ok ") != std::string::npos)
+			std::cout << line << std::endl;	// 0 ok 402, 1 ok 2, 2 ok 0
+	*/
+
+	/*	tests reserve() in the middle of an incremental resize: the resize finishes first, so no key is lost		32
+	MyHash<int, int> resizing(0.5, true);
+	for (int i = 0; i < 33; i++)
+		resizing.associate(i, i * i);
+	std::cout << resizing.isResizing() << std::endl;	// 1
+	resizing.reserve(10000);
+	int numFound = 0;
+	for (int i = 0; i < 33; i++)
+		if (resizing.find(i) != nullptr && *resizing.find(i) == i * i)
+			numFound++;
+	std::cout << resizing.isResizing() << " " << numFound << " " << resizing.getNumItems() << std::endl;	// 0 33 33
+	*/
+
+	/*	tests crackJoint() with the options crack() takes: a portfolio, a sample, and an anytime crack out of budget		33
+	std::vector<std::string> jointMsgs = { "Eiosrktf ligxsr hsqn gxzlort.", "Ukqrxqzt lzxrtfzl vkozt zitltl.", "Fgwgrn tbhteztr ziol." };
+	CrackOptions jointOptions;
+	jointOptions.portfolio = true;
+	JointCrackResult jpr = d.crackJoint(jointMsgs, jointOptions);
+	std::cout << jpr.solutions.size() << " " << jpr.solutions[0].key << std::endl;	// 1 ?x??cnoph?rs?yi?adlegwbu?t
+	jointOptions.portfolio = false;
+	jointOptions.sampleWords = 3;
+	JointCrackResult jsr = d.crackJoint(jointMsgs, jointOptions);
+	std::cout << jsr.solutions.size() << " from " << jsr.sampledWords << " words" << std::endl;	// 1 from 6 words
+	jointOptions.sampleWords = 0;
+	jointOptions.anytime = true;
+	jointOptions.maxSearchNodes = 2;
+	JointCrackResult jar = d.crackJoint(jointMsgs, jointOptions);
+	std::cout << jar.isPartial << " " << jar.partialScore << std::endl;	// 1 0.0909091
+	*/
+
+	/*	tests changing words while a long crack runs: the change doesn't wait for it, and the cracks after it see the new word		34
+	std::thread longCracker([&]()
+	{
+		CrackOptions longOptions;
+		longOptions.deadlineInMilliseconds = 2000;
+		d.crack("Xq rfjvn bzpl kxdm qwrtz yfvbn hjklp zxcvb mnqwe rtyui opasd fghjk lzxcv bnmqw ertyu iopas dfghj klzxc vbnmq", longOptions);
+	});
+	std::this_thread::sleep_for(std::chrono::milliseconds(100));
+	std::chrono::steady_clock::time_point changeStart = std::chrono::steady_clock::now();
+	bool isAdded = d.addWord("zorblax");
+	long long changeMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - changeStart).count();
+	std::cout << isAdded << (changeMs < 1000) << " " << d.crack("Mgkwsqb voss dttz zit eqhzqof qz zit iqkwgk zgfouiz").size() << std::endl;	// 11 12
+	longCracker.join();
+	*/
+
+	/*	tests a list with a blank line: it saves as a compiled list that loads again, without an empty word		35
+	{
+		std::ofstream blankList("blanklist.txt");
+		blankList << "hello\n\nworld\n";
+	}
+	WordList w8;
+	std::cout << w8.loadWordList("blanklist.txt") << w8.saveCompiledWordList("blanklist.p4d") << w8.contains("") << std::endl;	// 110
+	WordList w9;
+	std::cout << w9.loadWordList("blanklist.p4d") << w9.contains("hello") << w9.contains("world") << std::endl;	// 111
+	*/
+
 	/*
 		//1
 		v = d.crack("y qook ra bdttook yqkook");
@@ -1,6 +1,7 @@
 #ifndef PROVIDED_INCLUDED
 #define PROVIDED_INCLUDED
 
+#include <iosfwd>
 #include <string>
 #include <vector>
 
@@ -21,14 +22,53 @@ private:
 
 class WordListImpl;
 
+// How one length-shard of a WordList is doing (see WordList::setLazyLoading).
+struct WordListShardStats
+{
+	int wordLength;
+	bool isResident;
+	int numWords;
+	int numLoads;
+	long long numLookups;
+};
+
 class WordList
 {
 public:
 	WordList();
 	~WordList();
 	bool loadWordList(std::string filename);
+	// Loads using numThreads threads (0 means one per core).
+	bool loadWordList(std::string filename, int numThreads);
+	// Writes the list in the compiled form, which loadWordList also accepts.
+	bool saveCompiledWordList(std::string filename);
+	// If lazy, loadWordList only splits the list by word length, and each length is
+	// indexed the first time a word of that length is looked up.
+	void setLazyLoading(bool lazy);
+	std::vector<WordListShardStats> getShardStats() const;
+	// If out isn't nullptr, the word and pattern tables count their probes and rehashes,
+	// and their stats are printed to out whenever loadWordList returns. Call before loading.
+	void setTableStatsOutput(std::ostream* out);
+	// Prints the tables' chain lengths, probe counts, rehashes and memory use.
+	void printTableStats(std::ostream& out) const;
 	bool contains(std::string word) const;
 	std::vector<std::string> findCandidates(std::string cipherWord, std::string currTranslation) const;
+	// Change a loaded list in place, without reloading it, in O(L + B) per word (L = its length,
+	// B = words with its pattern). A length shared with a copy (see copyFrom) is copied first, but that
+	// copies only the words changed since they were last merged into its tables (at most 1024).
+	// Words are checked and lowercased like the lines of a loaded list. addWord returns false if
+	// the word isn't good or is already in the list, and removeWord if it isn't in the list.
+	// Like loadWordList, these must not run while another thread is looking words up.
+	bool addWord(std::string word);
+	bool removeWord(std::string word);
+	// Applies one change per line of the file: "+word" (or just "word") adds it and "-word"
+	// removes it. Returns how many words changed (adding each to changedWords, if given), or -1
+	// if the file can't be read.
+	int applyDelta(std::string filename, std::vector<std::string>* changedWords = nullptr);
+	// Makes this list a copy of other in O(S) (S = number of word lengths): the two share each
+	// length's words until one of them changes it, which copies just that length's changes. Neither may be
+	// changed while the copy is made, but other may be looked up in meanwhile.
+	void copyFrom(const WordList& other);
 	// We prevent a WordList object from being copied or assigned.
 	WordList(const WordList&) = delete;
 	WordList& operator=(const WordList&) = delete;
@@ -55,13 +95,201 @@ private:
 
 class DecrypterImpl;
 
+// Counters for the cache of crack results (see Decrypter::setCacheCapacity).
+struct CrackCacheStats
+{
+	long long hits;
+	long long misses;
+	long long evictions;
+	int numEntries;
+	std::size_t bytesUsed;
+	std::size_t capacityInBytes;
+};
+
+// A word known to be in the plaintext (see CrackOptions::cribs).
+struct CrackCrib
+{
+	std::string plaintext;
+	// Which word of the message it is, counting from 0 in the order the message is tokenized
+	// (across all the messages, for crackJoint), or -1 if it could be any of them.
+	int position = -1;
+};
+
+// How the search picks the next word to try the candidates of (see CrackOptions::wordOrder).
+// Which one finds the answer fastest depends on the message.
+enum class CrackWordOrder
+{
+	// The word with the most letters (counting repeats) the key doesn't know yet.
+	MostUnknownLetters,
+	// The word with the fewest candidates left that agree with what the key knows.
+	FewestCandidates,
+	// The longest word the key doesn't fully know yet.
+	LongestWord
+};
+
+// How often each word order won a portfolio crack (see CrackOptions::portfolio).
+struct CrackPortfolioStats
+{
+	CrackWordOrder wordOrder;
+	long long wins;
+	// How long the races it won took, added up.
+	long long winMicroseconds;
+};
+
+// A guess at how hard a message is to crack (see Decrypter::estimateCost).
+struct CrackCostEstimate
+{
+	// How many nodes (words tried) crack would search, and how many solutions it would find.
+	double searchNodes;
+	double solutions;
+	int numCipherLetters;
+	int numDistinctWords;
+	// How many words the search has to choose in turn; the rest are checked along the way.
+	int numSteps;
+};
+
+// Limits on, and hints for, one call to Decrypter::crack. Zero means no limit.
+struct CrackOptions
+{
+	int deadlineInMilliseconds = 0;
+	int maxSolutions = 0;
+	// How many steps (words tried) the search may take.
+	long long maxSearchNodes = 0;
+	// If the deadline or node budget runs out before any solution is found, return the best
+	// partial decryption seen instead (the one with the most words translated), '?' for the
+	// letters it doesn't know.
+	bool anytime = false;
+	// How many of the message's words (repeats included) may decrypt to something that isn't in
+	// the word list, like names or typos. A word the search gives up on keeps '?' for the letters
+	// no other word pins down. Results found with misses allowed aren't cached, or sampled.
+	int maxMissedWords = 0;
+	// Letters already known: fixedKey[i] is the plaintext letter for ciphertext letter 'a' + i,
+	// or '?' if it isn't known. Empty means none are known.
+	std::string fixedKey;
+	// Words that have to appear in the plaintext. Unlike the rest of it, they don't have to be
+	// in the word list. Results found with hints aren't cached.
+	std::vector<CrackCrib> cribs;
+	// For long messages: if more than zero, the key is solved from a sample of at least this
+	// many of the message's distinct words (the ones that pin it down best), then checked against
+	// the rest. The sample grows while it leaves too many keys open. Not used with cribs.
+	int sampleWords = 0;
+	CrackWordOrder wordOrder = CrackWordOrder::MostUnknownLetters;
+	// If set, crack, crackKeys and crackJoint race one search per word order, each on its own thread, and
+	// the first to finish gives the result while the others are told to stop. wordOrder is ignored.
+	bool portfolio = false;
+};
+
+struct CrackResult
+{
+	std::vector<std::string> solutions;
+	// If either is set, the search stopped early and solutions may be missing some.
+	// timedOut is also set when the node budget runs out.
+	bool timedOut = false;
+	bool hitSolutionLimit = false;
+	bool fromCache = false;
+	// If set, solutions holds one partial decryption (see CrackOptions::anytime), and
+	// partialScore is the share of the message's words it turns into words in the word list.
+	bool isPartial = false;
+	double partialScore = 0;
+	// How many times the search asked for a word's candidates, and how many of those were
+	// already filtered for what it knew about the word's letters.
+	long long candidateListLookups = 0;
+	long long candidateListHits = 0;
+	// How many distinct words the key was solved from, if it was solved from a sample (else 0).
+	int sampledWords = 0;
+	// How many nodes the search took (0 if the result came from the cache).
+	long long searchNodes = 0;
+	// The word order of the search that gave the result (with CrackOptions::portfolio, the one that won).
+	CrackWordOrder wordOrder = CrackWordOrder::MostUnknownLetters;
+};
+
+struct CrackKeysResult
+{
+	// Each solution's key, sorted: keys[s][i] is the plaintext letter for ciphertext letter
+	// 'a' + i, or '?' if it isn't known (the message doesn't use it).
+	std::vector<std::string> keys;
+	bool timedOut = false;
+	bool hitSolutionLimit = false;
+	bool isPartial = false;
+	double partialScore = 0;
+	int sampledWords = 0;
+	long long searchNodes = 0;
+	CrackWordOrder wordOrder = CrackWordOrder::MostUnknownLetters;
+};
+
+// One key that decrypts every message given to Decrypter::crackJoint.
+struct JointSolution
+{
+	// key[i] is the plaintext letter for ciphertext letter 'a' + i, or '?' if no message uses that letter.
+	std::string key;
+	// plaintexts[m] is message m decrypted with key.
+	std::vector<std::string> plaintexts;
+};
+
+struct JointCrackResult
+{
+	std::vector<JointSolution> solutions;
+	// If either is set, the search stopped early and solutions may be missing some.
+	bool timedOut = false;
+	bool hitSolutionLimit = false;
+	// The same as in CrackResult, counting the words of every message.
+	bool isPartial = false;
+	double partialScore = 0;
+	int sampledWords = 0;
+	long long searchNodes = 0;
+	CrackWordOrder wordOrder = CrackWordOrder::MostUnknownLetters;
+};
+
 class Decrypter
 {
 public:
 	Decrypter();
 	~Decrypter();
+	// May be called while cracks are running: the new list is built while they keep using the
+	// old one, and cracks that start after load returns use the new one. The old list is freed
+	// once the last crack using it returns. If the list can't be loaded, the old one stays.
 	bool load(std::string filename);
+	// See WordList::setLazyLoading. Call before load.
+	void setLazyLoading(bool lazy);
+	std::vector<WordListShardStats> getShardStats() const;
+	// See WordList::setTableStatsOutput. Call before load.
+	void setTableStatsOutput(std::ostream* out);
+	void printTableStats(std::ostream& out) const;
+	// Results of crack are cached (least recently used entries are dropped to stay
+	// under the capacity). A message whose letters are relabeled hits the same entry.
+	// A capacity of 0 turns the cache off.
+	void setCacheCapacity(std::size_t bytes);
+	CrackCacheStats getCacheStats() const;
+	// Wins of each word order in portfolio cracks so far. If out isn't nullptr, a line saying
+	// which order won (and how fast) is also written to it after each portfolio crack.
+	std::vector<CrackPortfolioStats> getPortfolioStats() const;
+	void setPortfolioLog(std::ostream* out);
+	// Change the word list without reloading it (see WordList::addWord). Like load, they make a
+	// changed copy (sharing everything the change doesn't touch) and swap it in, so cracks never wait for
+	// them: cracks already running finish with the old list, and the ones that start after the change
+	// returns see all of it. Only the cached results of messages with a word of the same letter
+	// pattern as a changed word are dropped.
+	bool addWord(const std::string& word);
+	bool removeWord(const std::string& word);
+	int applyDelta(const std::string& filename);
+	// crack may be called from several threads at once, once the first load has returned.
 	std::vector<std::string> crack(const std::string& ciphertext);
+	CrackResult crack(const std::string& ciphertext, const CrackOptions& options);
+	// Like crack, but returns each solution's key instead of the decrypted message, so a long
+	// message doesn't get copied once per solution. Results aren't cached.
+	CrackKeysResult crackKeys(const std::string& ciphertext, const CrackOptions& options = CrackOptions());
+	// Cracks messages known to share one key as a single problem, so every message's words
+	// narrow down the same key. Every option works as it does for crack, but results aren't cached.
+	JointCrackResult crackJoint(const std::vector<std::string>& ciphertexts, const CrackOptions& options = CrackOptions());
+	// Writes the order crack would try the message's words in under options (each word, the
+	// letters it adds and the words that get checked once it's translated), for finding out why
+	// a message is slow. Word orders that depend on the search as it goes have no plan.
+	void explainPlan(const std::string& ciphertext, std::ostream& out, const CrackOptions& options = CrackOptions()) const;
+	// Guesses from the word list alone (how many words share each word's letter pattern, and
+	// how much the words' letters overlap) how much work crack with no options would take, so
+	// slow messages can be sent elsewhere, given longer deadlines or turned away. It costs about
+	// as much as looking up each word's candidates, not a search.
+	CrackCostEstimate estimateCost(const std::string& ciphertext) const;
 	// We prevent a Decrypter object from being copied or assigned.
 	Decrypter(const Decrypter&) = delete;
 	Decrypter& operator=(const Decrypter&) = delete;
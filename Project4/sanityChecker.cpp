@@ -51,7 +51,7 @@ void testMyHash()
 	m.associate(333, "Lucy");
 	m.associate(111, "Fred");
 	assert(m.getNumItems() == 3);
-	assert(abs(m.getLoadFactor() - 0.03) < 0.00001);
+	assert(abs(m.getLoadFactor() - 3.0 / 64) < 0.00001);
 	string* s = m.find(333);
 	assert(s != nullptr  &&  *s == "Lucy");
 	m.associate(333, "Ricky");
@@ -71,7 +71,7 @@ void testMyHash()
 	m.reset();
 	m.associate(444, "David");
 	assert(m.getNumItems() == 1);
-	assert(abs(m.getLoadFactor() - 0.01) < 0.00001);
+	assert(abs(m.getLoadFactor() - 1.0 / 64) < 0.00001);
 }
 
 void testTokenizer()